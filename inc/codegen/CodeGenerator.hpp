@@ -0,0 +1,86 @@
+#ifndef CODE_GENERATOR_HPP
+# define CODE_GENERATOR_HPP
+
+# include <ostream>
+# include <string>
+# include <vector>
+# include "ScannerTables.hpp"
+# include "KeywordTable.hpp"
+# include "../parser/Parser.hpp"
+
+struct GeneratorOptions {
+    bool direct;
+    bool mmap;
+    bool backup;
+    bool simd;
+    bool parallel;
+    bool batch;
+
+    GeneratorOptions();
+};
+
+/*
+Writes lex.yy.c: the user's %{ %} code, the scanner tables, a yylex()
+whose inner loop walks the tables with longest-match (last accepting
+position) tracking, a switch over the rule actions, and the user code
+section. With GeneratorOptions::direct the tables are replaced by one
+labelled block of branches per DFA state, linked by gotos. When the DFA
+cannot back up (GeneratorOptions::backup is false), the last-accept
+bookkeeping is left out of the loop and the match is read off the state
+the scan stopped in. States that loop on a large set of bytes skip runs
+of them with SSE2/AVX2 kernels (GeneratorOptions::simd). Keywords taken
+out of the DFA are looked up in a perfect hash after their host rules match.
+Table scanners also get yyscan_parallel() for multi-threaded tokenizing of
+an in-memory buffer (compiled in with YY_PARALLEL) and yyscan_batch() for
+interleaved scanning of many short buffers (YY_BATCH).
+*/
+class CodeGenerator {
+    private:
+    const ScannerTables& tables;
+    const std::vector<Rule>& rules;
+    const KeywordTable& keywords;
+    std::string headerCode;
+    std::string userCode;
+    GeneratorOptions options;
+    std::vector<std::vector<std::pair<int, int>>> skipRanges;
+
+    static const int MIN_SKIP_BYTES = 8;
+    static const int MAX_SKIP_RANGES = 4;
+
+    struct ByteRange {
+        int last;
+        int target;
+    };
+
+    void emitPrologue(std::ostream& out) const;
+    void emitTables(std::ostream& out) const;
+    void emitKeywords(std::ostream& out) const;
+    void emitKeywordCheck(std::ostream& out, int depth) const;
+    void emitInput(std::ostream& out) const;
+    void emitTransition(std::ostream& out, int depth) const;
+    void findSkipStates();
+    bool hasSkipStates() const;
+    void emitSkipKernels(std::ostream& out) const;
+    void emitTableMatch(std::ostream& out) const;
+    void emitBranches(std::ostream& out, const std::vector<ByteRange>& ranges,
+        size_t begin, size_t end, int state, int depth) const;
+    void emitDirectMatch(std::ostream& out) const;
+    void emitScanner(std::ostream& out) const;
+    void emitParallel(std::ostream& out) const;
+    void emitBatch(std::ostream& out) const;
+    void emitActions(std::ostream& out) const;
+    void emitEpilogue(std::ostream& out) const;
+    bool readsYytext() const;
+
+    static void emitArray(std::ostream& out, const std::string& name,
+        const std::vector<int32_t>& values);
+
+    public:
+    CodeGenerator(const ScannerTables& tables, const std::vector<Rule>& rules,
+        const KeywordTable& keywords, const std::string& headerCode, const std::string& userCode,
+        const GeneratorOptions& options);
+
+    void generate(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef KEYWORD_TABLE_HPP
+# define KEYWORD_TABLE_HPP
+
+# include <string>
+# include <vector>
+# include <cstdint>
+# include "../parser/Parser.hpp"
+
+struct Keyword {
+    std::string text;
+    int rule;
+};
+
+/*
+Takes literal-string rules ("if", "while", ...) out of the DFA when the
+general rules already match the whole string, and looks them up in a
+perfect hash instead, after one of those general rules (the hosts) has
+matched.
+
+Without a keyword K (text w), a token w ends with the best remaining rule
+R that matches w; the original scanner reports K exactly when K has the
+higher priority. So the generated scanner checks the hosts' matches
+against the table and swaps in K in that case, and all other matches are
+unchanged.
+
+The table is hash-and-displace: a key's first hash picks a bucket, the
+bucket's displacement seeds a second hash that picks the slot. Seeds are
+searched at generation time so no two keywords share a slot.
+*/
+class KeywordTable {
+    private:
+
+    static const size_t MIN_LENGTH = 2;
+    static const uint32_t MAX_SEED = 1 << 16;
+
+    std::vector<Keyword> keywords;
+    std::vector<int> hosts;
+    std::vector<Rule> remaining;
+    std::vector<int32_t> displacements;
+    std::vector<int32_t> slots;
+
+    void buildHash();
+
+    public:
+    KeywordTable();
+    KeywordTable(const std::vector<Rule>& rules);
+
+    static bool literalString(const RegexNode *node, std::string& text);
+    static uint32_t hash(const std::string& text, uint32_t seed);
+
+    bool isEmpty() const;
+    const std::vector<Keyword>& getKeywords() const;
+    const std::vector<int>& getHosts() const;
+    const std::vector<Rule>& getRemainingRules() const;
+    const std::vector<int32_t>& getDisplacements() const;
+    const std::vector<int32_t>& getSlots() const;
+};
+
+#endif
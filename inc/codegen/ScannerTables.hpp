@@ -0,0 +1,75 @@
+#ifndef SCANNER_TABLES_HPP
+# define SCANNER_TABLES_HPP
+
+# include <vector>
+# include <string>
+# include <cstdint>
+# include "../dfa/DFA.hpp"
+
+typedef enum {
+    TABLES_FULL,
+    TABLES_COMB,
+    TABLES_COMPACT,
+} TableMode;
+
+/*
+Transition tables in the layout a generated scanner reads.
+
+TABLES_FULL is the DFA's dense next[state * classes + class] table: one
+load per byte, and the largest.
+
+TABLES_COMB packs the rows into base/next/check comb vectors: the entry of
+state s on class c sits at base[s] + c and belongs to s only if
+check[base[s] + c] == s; otherwise there is no transition.
+
+TABLES_COMPACT also gives each state a default state (def) and stores only
+the entries where the two differ; a failed check moves down the default
+chain, like flex's compressed tables.
+
+In every layout byte 0 has a class of its own whose column is empty, so
+the NUL sentinel at the end of the scanner's buffer always jams; the
+scanner then tells the sentinel from a real NUL and takes the real
+transition from getNulTransitions().
+*/
+class ScannerTables {
+    private:
+
+    static const int MAX_CHAIN = 8;
+    static const int DEFAULT_WINDOW = 64;
+
+    TableMode mode;
+    int width;
+    int stateCount;
+    std::vector<int32_t> classOf;
+    std::vector<int32_t> accept;
+    std::vector<int32_t> nulTransitions;
+    std::vector<int32_t> base;
+    std::vector<int32_t> def;
+    std::vector<int32_t> next;
+    std::vector<int32_t> check;
+
+    void buildComb(const std::vector<int32_t>& table, bool defaults);
+
+    public:
+
+    ScannerTables(const DFA& dfa, TableMode mode);
+
+    int32_t lookup(int32_t state, int cls) const;
+    size_t byteSize() const;
+
+    TableMode getMode() const;
+    int getWidth() const;
+    int getStateCount() const;
+    const std::vector<int32_t>& getClassOf() const;
+    const std::vector<int32_t>& getAccept() const;
+    const std::vector<int32_t>& getNulTransitions() const;
+    const std::vector<int32_t>& getBase() const;
+    const std::vector<int32_t>& getDefault() const;
+    const std::vector<int32_t>& getNext() const;
+    const std::vector<int32_t>& getCheck() const;
+
+    static int elementBytes(const std::vector<int32_t>& values);
+    static const char *modeName(TableMode mode);
+};
+
+#endif
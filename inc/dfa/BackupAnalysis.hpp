@@ -0,0 +1,35 @@
+#ifndef BACKUP_ANALYSIS_HPP
+# define BACKUP_ANALYSIS_HPP
+
+# include <ostream>
+# include <string>
+# include <vector>
+# include "DFA.hpp"
+
+/*
+Finds the states of a DFA that can make the scanner back up: a
+non-accepting state reached after at least one byte (every state but the
+start, which counts too if a transition leads back into it). If the scan
+stops there, on a byte with no transition or at the end of input, it has
+to return to the last accepting position.
+
+When there are none, every token ends in the state the scan stopped in,
+and the generated scanner needs no last-accept bookkeeping.
+*/
+class BackupAnalysis {
+    private:
+    const DFA& dfa;
+    std::vector<int> states;
+
+    std::vector<int> liveRules(int state) const;
+    void writeBytes(std::ostream& out, const std::vector<bool>& bytes) const;
+
+    public:
+    BackupAnalysis(const DFA& dfa);
+
+    bool hasBackingUp() const;
+    const std::vector<int>& getStates() const;
+    void writeReport(std::ostream& out, const std::vector<Rule>& rules, const std::string& file) const;
+};
+
+#endif
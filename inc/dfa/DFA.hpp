@@ -1,38 +1,77 @@
 #ifndef DFA_HPP
 # define DFA_HPP
 
-# include <map>
-# include <set>
-# include <queue>
+# include <vector>
+# include <cstdint>
 # include "../nfa/NFA.hpp"
+# include "../regex/Positions.hpp"
 
-struct DFAState {
-    int id;
-    std::map<char, DFAState*> transitions;
-    bool accepting;
-    int ruleNumber;
+/*
+Interned NFA state sets for subset construction. Every set is stored back
+to back in one pool and addressed by its DFA state id; an open-addressed
+hash table of ids finds existing sets without keeping a second copy as a
+key.
+*/
+class StateSetTable {
+    private:
+
+    std::vector<int> pool;
+    std::vector<size_t> offsets;
+    std::vector<size_t> hashes;
+    std::vector<int> buckets;
+
+    bool equals(int id, const StateSet& set) const;
+    void grow();
 
-    std::set<NFAState*> nfaStates;
+    public:
+
+    StateSetTable();
 
-    DFAState(int id, const std::set<NFAState*>& nfaStates);
+    int find(const StateSet& set) const;
+    int intern(const StateSet& set, bool& inserted);
+    size_t size() const;
+    const int *begin(int id) const;
+    const int *end(int id) const;
+    void clear();
 };
 
+/*
+The DFA is stored as flat tables indexed by state id. State 0 is the start
+state. next is row-major, next[state * classCount + class], with -1 for
+"no transition"; accept holds the winning rule number of each state, or
+-1 when the state is not accepting.
+*/
 class DFA {
     private:
-    
-    DFAState* start;
-    std::set<DFAState*> states;
+
+    ByteClasses classes;
+    int stateCount;
+    std::vector<int32_t> next;
+    std::vector<int32_t> accept;
+
+    static DFA fromNFAParallel(const NFA& nfa, int threads);
 
     public:
     
-    DFA(DFAState* start, const std::set<DFAState*>& states);
-    ~DFA();
+    DFA(const ByteClasses& classes, int stateCount,
+        const std::vector<int32_t>& next, const std::vector<int32_t>& accept);
 
-    DFAState *getStart() const;
-    std::set<DFAState*> getStates() const;
-    
-    static DFA fromNFA(const NFA& nfa);
-    static std::set<NFAState*> epsilonClosure(const std::set<NFAState*>& states);
+    int getStart() const;
+    int getStateCount() const;
+    int getClassCount() const;
+    const ByteClasses& getClasses() const;
+    int32_t getNext(int state, int cls) const;
+    int32_t getAccept(int state) const;
+    const std::vector<int32_t>& getNextTable() const;
+    const std::vector<int32_t>& getAcceptTable() const;
+
+    size_t longestMatch(const char *input, size_t length, int& rule) const;
+    DFA minimize() const;
+
+    static DFA fromNFA(const NFA& nfa, int threads = 1);
+    static DFA fromRules(const std::vector<Rule>& rules);
+    static StateSet epsilonClosure(const NFA& nfa, const StateSet& states);
+    static StateSet epsilonClosure(const NFA& nfa, const StateSet& states, StateMarks& marks);
 };
 
-#endif
\ No newline at end of file
+#endif
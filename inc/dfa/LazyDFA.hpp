@@ -0,0 +1,43 @@
+#ifndef LAZY_DFA_HPP
+# define LAZY_DFA_HPP
+
+# include "DFA.hpp"
+
+/*
+On-demand DFA over an NFA, in the style of RE2. A state and its transitions
+are only built when the input reaches them, and they live in a cache with
+a fixed byte budget. When a new state would exceed the budget, the whole
+cache is flushed and matching continues from the state being built. Memory
+stays bounded however large the full DFA would be.
+*/
+class LazyDFA {
+    private:
+
+    static const int32_t UNKNOWN = -2;
+
+    const NFA& nfa;
+    int width;
+    size_t budget;
+    size_t used;
+    size_t flushes;
+    StateSetTable states;
+    std::vector<int32_t> next;
+    std::vector<int32_t> accept;
+    StateSet startSet;
+    int32_t start;
+    StateMarks marks;
+
+    int32_t addState(const StateSet& set);
+    int32_t computeNext(int32_t state, int cls);
+    void flush();
+
+    public:
+
+    LazyDFA(const NFA& nfa, size_t budget);
+
+    size_t longestMatch(const char *input, size_t length, int& rule);
+    size_t getCachedStates() const;
+    size_t getFlushes() const;
+};
+
+#endif
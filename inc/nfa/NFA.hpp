@@ -3,25 +3,73 @@
 
 # include "../parser/Parser.hpp"
 # include "../regex/RegexNode.hpp"
+# include "../utils/Arena.hpp"
 # include <vector>
 # include <queue>
 
+/*
+A set of NFA states, kept as a sorted vector of NFAState::id. Subset
+construction interns these in a hash table instead of comparing ordered
+pointer sets.
+*/
+typedef std::vector<int> StateSet;
+
+struct StateSetHash {
+    size_t operator()(const StateSet& set) const;
+};
+
+/*
+Visited marks over NFA state ids. Bumping the stamp clears every mark at
+once, so one instance can be reused across closure computations.
+*/
+class StateMarks {
+    private:
+
+    std::vector<unsigned> marks;
+    unsigned stamp;
+
+    public:
+
+    StateMarks(size_t size);
+
+    void clear();
+    bool insert(int id);
+};
+
+/*
+All states of one compilation live in the NFA's arena and refer to each
+other by index, so building is a bump allocation per state and the whole
+automaton is released at once.
+*/
 class NFA {
     private:
 
-    NFAState* start;
-    std::set<NFAState*> states;
+    Arena<NFAState> states;
+    int start;
+    ByteClasses classes;
+    std::vector<int> transitionClasses;
+    std::vector<int> sccOf;
+    std::vector<StateSet> closures;
+
+    void computeClasses();
+    void computeClosures();
 
     public:
 
-    NFA(NFAState* start);
-    ~NFA();
+    NFA();
+
+    int addState();
+    void addTransition(int from, const std::bitset<256>& chars, int to);
+    void addEpsilon(int from, int to);
 
-    NFAState* getStart() const;
-    std::set<NFAState*> getStates() const;
+    int getStart() const;
+    const NFAState& getState(int id) const;
+    size_t getStateCount() const;
+    const int *getTransitionClasses(int id) const;
+    const StateSet& getClosure(int id) const;
+    const ByteClasses& getClasses() const;
 
     static NFA combineRules(const std::vector<Rule>& rules);
-    
 };
 
-#endif
\ No newline at end of file
+#endif
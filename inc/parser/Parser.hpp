@@ -2,45 +2,72 @@
 # define PARSER_HPP
 
 # include <vector>
+# include <deque>
 # include <map>
-# include "RegexNode.hpp"
+# include "../regex/AltNode.hpp"
+# include "../regex/CharClassNode.hpp"
+# include "../regex/ConcatNode.hpp"
+# include "../regex/DotNode.hpp"
+# include "../regex/LiteralNode.hpp"
+# include "../regex/PlusNode.hpp"
+# include "../regex/QuestionNode.hpp"
+# include "../regex/RepeatNode.hpp"
+# include "../regex/StarNode.hpp"
 # include "../tokenizer/Tokenizer.hpp"
 
 struct Rule {
     RegexNode *pattern;
     std::string action;
     int priority;
+    int line;
 
-    Rule(RegexNode *p, const std::string& action, int priority);
+    Rule(RegexNode *p, const std::string& action, int priority, int line);
 };
 
+/*
+Pulls tokens from the .l file's tokenizer through a small lookahead
+buffer. Each definition is parsed once, from a tokenizer pushed over its
+pattern, into an AST that every reference to it clones.
+*/
 class Parser {
     private:
-    std::vector<Token> _tokens;
-    std::map<std::string, std::string> _definitions;
-    size_t _pos;
+    std::vector<Tokenizer> _sources;
+    std::vector<Token> _origins;
+    std::deque<Token> _lookahead;
+    std::map<std::string, RegexNode *> _definitions;
+    std::string _headerCode;
+    std::string _userCode;
 
-    Token peek() const;
+    Token fetch();
+    const Token& peek();
+    const Token& peekNext();
     Token advance();
-    bool isAtEnd() const;
+    bool isAtEnd();
 
     void parseHeader();
-    void expandReferences();
-    std::string expandDefinitions(const std::string& pattern, const Token& token);
+    RegexNode *parseDefinition(std::string_view pattern, const Token& token);
+    static std::string unescape(std::string_view raw);
 
     RegexNode *parsePattern();
     RegexNode *parseAlt();
     RegexNode *parseConcat();
     RegexNode *parsePostfix();
+    static RegexNode *parseRepeat(RegexNode *node, const Token& token);
     RegexNode *parsePrimary();
 
     std::vector<Rule> parseRules();
     void resolveActions(std::vector<Rule>& rules);
 
     public:
-    Parser(const std::vector<Token>& tokens);
+    Parser(const Tokenizer& tokenizer);
+    ~Parser();
+
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
     
     std::vector<Rule> parse();
+    const std::string& getHeaderCode() const;
+    const std::string& getUserCode() const;
 };
 
 #endif
\ No newline at end of file
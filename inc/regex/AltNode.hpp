@@ -6,7 +6,9 @@
 class AltNode : public BinaryNode {
     public:
     AltNode(RegexNode* l, RegexNode* r);
-    NFAFragment toNFA(int& stateCounter) override;
+    RegexNode *clone() const override;
+    NFAFragment toNFA(NFA& nfa) const override;
+    PositionInfo computePositions(PositionTable& table) const override;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef BYTE_CLASSES_HPP
+# define BYTE_CLASSES_HPP
+
+# include <bitset>
+# include <vector>
+
+/*
+Partition of the 256 byte values into equivalence classes: two bytes share
+a class when every literal, character class and dot in the rules either
+matches both or neither of them. Automata built over classes behave
+exactly as if built over raw bytes.
+*/
+class ByteClasses {
+    private:
+    int classOf[256];
+    unsigned char first[256];
+    int count;
+
+    public:
+    ByteClasses();
+
+    void refine(const std::bitset<256>& chars);
+
+    int getClass(unsigned char c) const;
+    const int *getMap() const;
+    int getCount() const;
+    unsigned char representative(int cls) const;
+    std::vector<unsigned char> members(int cls) const;
+};
+
+#endif
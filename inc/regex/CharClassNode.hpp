@@ -10,11 +10,16 @@ class CharClassNode : public RegexNode {
 
     public:
     CharClassNode(const std::string& pattern, bool negated);
-    NFAFragment toNFA(int& stateCounter) override;
+    static CharClassNode *fromChars(const std::bitset<256>& chars);
+    RegexNode *clone() const override;
+    NFAFragment toNFA(NFA& nfa) const override;
+    PositionInfo computePositions(PositionTable& table) const override;
+    void collectByteClasses(ByteClasses& classes) const override;
     const std::string& getPattern() const;
     bool isNegated() const;
 
-    std::set<char> expandCharClass(const std::string& pattern);
+    std::set<char> expandCharClass(const std::string& pattern) const;
+    std::bitset<256> getChars() const;
 };
 
 #endif
\ No newline at end of file
@@ -4,7 +4,10 @@
 # include "RegexNode.hpp"
 
 class DotNode : public RegexNode {
-    NFAFragment toNFA(int& stateCounter) override;
+    RegexNode *clone() const override;
+    NFAFragment toNFA(NFA& nfa) const override;
+    PositionInfo computePositions(PositionTable& table) const override;
+    void collectByteClasses(ByteClasses& classes) const override;
 };
 
 #endif
\ No newline at end of file
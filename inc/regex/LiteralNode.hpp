@@ -9,7 +9,10 @@ class LiteralNode : public RegexNode {
 
     public:
     LiteralNode(char c);
-    NFAFragment toNFA(int& stateCounter) override;
+    RegexNode *clone() const override;
+    NFAFragment toNFA(NFA& nfa) const override;
+    PositionInfo computePositions(PositionTable& table) const override;
+    void collectByteClasses(ByteClasses& classes) const override;
     char getChar() const;
 };
 
@@ -6,7 +6,9 @@
 class PlusNode : public UnaryNode {
     public:
     PlusNode(RegexNode* c);
-    NFAFragment toNFA(int& stateCounter) override;
+    RegexNode *clone() const override;
+    NFAFragment toNFA(NFA& nfa) const override;
+    PositionInfo computePositions(PositionTable& table) const override;
 };
 
 #endif
\ No newline at end of file
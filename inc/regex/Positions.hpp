@@ -0,0 +1,47 @@
+#ifndef POSITIONS_HPP
+# define POSITIONS_HPP
+
+# include <bitset>
+# include <vector>
+# include "ByteClasses.hpp"
+
+/*
+Data for the direct regex-to-DFA construction (Aho, Sethi, Ullman). Every
+leaf of every rule is a position; each rule also gets an end-marker
+position that carries its rule number. Position sets are sorted vectors of
+position ids.
+*/
+struct PositionInfo {
+    bool nullable;
+    std::vector<int> firstpos;
+    std::vector<int> lastpos;
+
+    PositionInfo();
+};
+
+class PositionTable {
+    private:
+
+    std::vector<std::bitset<256>> chars;
+    std::vector<int> rules;
+    std::vector<std::vector<int>> followpos;
+    std::vector<std::vector<int>> classes;
+
+    public:
+
+    PositionTable();
+
+    int addPosition(const std::bitset<256>& chars);
+    int addEndMarker(int rule);
+    void addFollow(const std::vector<int>& from, const std::vector<int>& to);
+    void finish(const ByteClasses& byteClasses);
+
+    size_t size() const;
+    int getRule(int pos) const;
+    const std::vector<int>& getFollow(int pos) const;
+    const std::vector<int>& getClasses(int pos) const;
+
+    static std::vector<int> merge(const std::vector<int>& a, const std::vector<int>& b);
+};
+
+#endif
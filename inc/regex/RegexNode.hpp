@@ -4,11 +4,25 @@
 # include <string>
 # include <map>
 # include <set>
+# include <bitset>
+# include "ByteClasses.hpp"
 
+class NFA;
+class PositionTable;
+struct PositionInfo;
+
+/*
+Thompson states have either one byte-set transition or at most two
+epsilon transitions, so both fit inline and the state stays trivially
+destructible for the NFA's arena. Unused slots hold -1.
+*/
 struct NFAState {
     int id;
-    std::map<char, std::set<NFAState*>> transitions;
-    std::set<NFAState*> epsilonTransitions;
+    std::bitset<256> chars;
+    int out;
+    int epsilon[2];
+    int classBegin;
+    int classEnd;
     bool accepting;
     int ruleNumber;
 
@@ -16,16 +30,19 @@ struct NFAState {
 };
 
 struct NFAFragment {
-    NFAState *start;
-    NFAState *end;
+    int start;
+    int end;
 
-    NFAFragment(NFAState *start, NFAState *end);
+    NFAFragment(int start, int end);
 };
 
 class RegexNode {
     public:
     virtual ~RegexNode() = default;
-    virtual NFAFragment toNFA(int& stateCounter) = 0;
+    virtual RegexNode *clone() const = 0;
+    virtual NFAFragment toNFA(NFA& nfa) const = 0;
+    virtual void collectByteClasses(ByteClasses& classes) const = 0;
+    virtual PositionInfo computePositions(PositionTable& table) const = 0;
 };
 
 class UnaryNode : public RegexNode {
@@ -36,7 +53,9 @@ class UnaryNode : public RegexNode {
     UnaryNode(RegexNode* c);
     ~UnaryNode();
 
+    void collectByteClasses(ByteClasses& classes) const override;
     RegexNode *getChild() const;
+    void detach();
 };
 
 class BinaryNode : public RegexNode {
@@ -48,8 +67,10 @@ class BinaryNode : public RegexNode {
     BinaryNode(RegexNode* l, RegexNode *r);
     ~BinaryNode();
 
+    void collectByteClasses(ByteClasses& classes) const override;
     RegexNode *getLeft() const;
     RegexNode *getRight() const;
+    void detach();
 };
 
 #endif
\ No newline at end of file
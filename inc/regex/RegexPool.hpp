@@ -0,0 +1,84 @@
+#ifndef REGEX_POOL_HPP
+# define REGEX_POOL_HPP
+
+# include <unordered_map>
+# include <vector>
+# include "AltNode.hpp"
+# include "CharClassNode.hpp"
+# include "ConcatNode.hpp"
+# include "DotNode.hpp"
+# include "LiteralNode.hpp"
+# include "PlusNode.hpp"
+# include "QuestionNode.hpp"
+# include "RepeatNode.hpp"
+# include "StarNode.hpp"
+
+/*
+Hash-consed regex DAG shared by all rules. Interning a tree rebuilds it
+bottom-up from unique nodes, so structurally equal subexpressions of any
+rule become one node. Along the way nested closures collapse (a** is a*,
+(a+)? is a*) and the single-byte alternatives of an alternation merge
+into one character class. The pool owns every node it hands out.
+*/
+class RegexPool {
+    private:
+    typedef enum {
+        NODE_LITERAL,
+        NODE_CLASS,
+        NODE_DOT,
+        NODE_CONCAT,
+        NODE_ALT,
+        NODE_STAR,
+        NODE_PLUS,
+        NODE_QUESTION,
+        NODE_REPEAT,
+    } Kind;
+
+    struct Key {
+        Kind kind;
+        int left;
+        int right;
+        std::string bytes;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    std::unordered_map<Key, RegexNode *, KeyHash> _nodes;
+    std::unordered_map<const RegexNode *, int> _ids;
+    std::vector<RegexNode *> _owned;
+    size_t _treeNodes;
+
+    RegexNode *canonical(const RegexNode *node);
+    RegexNode *find(const Key& key) const;
+    RegexNode *add(const Key& key, RegexNode *node);
+    int id(const RegexNode *node) const;
+
+    RegexNode *literal(char c);
+    RegexNode *chars(const std::bitset<256>& set, const RegexNode *original);
+    RegexNode *dot();
+    RegexNode *concat(RegexNode *left, RegexNode *right);
+    RegexNode *alt(RegexNode *left, RegexNode *right);
+    RegexNode *closure(Kind kind, RegexNode *child);
+    RegexNode *repeat(RegexNode *child, int min, int max);
+
+    static bool singleByte(const RegexNode *node, std::bitset<256>& set);
+    void flattenAlt(RegexNode *node, std::vector<RegexNode *>& alternatives) const;
+
+    public:
+    RegexPool();
+    ~RegexPool();
+
+    RegexPool(const RegexPool&) = delete;
+    RegexPool& operator=(const RegexPool&) = delete;
+
+    RegexNode *intern(RegexNode *tree);
+
+    size_t getNodeCount() const;
+    size_t getTreeNodeCount() const;
+};
+
+#endif
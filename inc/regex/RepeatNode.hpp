@@ -0,0 +1,29 @@
+#ifndef REPEAT_NODE_HPP
+# define REPEAT_NODE_HPP
+
+# include "RegexNode.hpp"
+
+/*
+Counted repetition x{min,max}; max is UNBOUNDED for x{min,}. The copies
+past min are nested optionals, x(x(x)?)?, rather than x?x?x?, so every
+prefix of the input reaches a single copy and both the NFA and the
+followpos sets grow linearly with the bound.
+*/
+class RepeatNode : public UnaryNode {
+    private:
+    int min;
+    int max;
+
+    public:
+    static const int UNBOUNDED = -1;
+    static const int MAX_COUNT = 32767;
+
+    RepeatNode(RegexNode* c, int min, int max);
+    RegexNode *clone() const override;
+    NFAFragment toNFA(NFA& nfa) const override;
+    PositionInfo computePositions(PositionTable& table) const override;
+    int getMin() const;
+    int getMax() const;
+};
+
+#endif
@@ -3,7 +3,9 @@
 
 # include <iostream>
 # include <vector>
+# include <deque>
 # include <string>
+# include <string_view>
 # include <stdexcept>
 
 typedef enum {
@@ -40,24 +42,42 @@ typedef enum {
     TOK_ERROR,
 } TokenType;
 
+/*
+A token's value is a slice of the tokenizer's input (strings and escapes
+are left undecoded), so the input must outlive the tokens.
+*/
 typedef struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
     int line;
     int column;
 
-    Token(TokenType type, const std::string& value, int line, int col);
+    Token(TokenType type, std::string_view value, int line, int col);
 
 } Token;
 
+/*
+Produces the tokens of a .l file on demand: next() runs the tokenizer
+for the current section just far enough to have a token to return.
+*/
 class Tokenizer {
     private:
-    std::string _input;
+    typedef enum {
+        SECTION_HEADER,
+        SECTION_RULES,
+        SECTION_CODE,
+        SECTION_PATTERN,
+        SECTION_END,
+    } Section;
+
+    std::string_view _input;
     size_t _pos;
     int _line;
     int _column;
+    Section _section;
+    bool _inPattern;
 
-    std::vector<Token> tokens;
+    std::deque<Token> _pending;
 
     char peek() const;
     char peekNext() const;
@@ -74,19 +94,21 @@ class Tokenizer {
     Token lexPercentDirective();
     Token lexBrace();
     Token lexDefiniton();
+    Token lexPatternToken();
 
     void tokenizeAction();
     void tokenizePattern();
     void tokenizeRules();
     void tokenizeHeader();
     void tokenizeCode();
-    
+
     public:
-    Tokenizer(const std::string& input);
+    Tokenizer(std::string_view input);
 
     static const char* tokenTypeToString(TokenType type);
-    std::vector<Token> tokenizePatternExtern(); // this is public to be used in definition expansion in the parser
+    static Tokenizer forPattern(std::string_view pattern); // a lone pattern, for definition expansion in the parser
 
+    Token next();
     std::vector<Token> tokenize();
 };
 
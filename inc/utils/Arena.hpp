@@ -0,0 +1,84 @@
+#ifndef ARENA_HPP
+# define ARENA_HPP
+
+# include <vector>
+# include <new>
+# include <cstddef>
+# include <type_traits>
+
+/*
+Region allocator for automaton nodes. Objects live in fixed-size chunks
+and are addressed by a stable index; nothing is freed individually and
+the whole region is released at once, so T must be trivially
+destructible.
+*/
+template <typename T>
+class Arena {
+	static_assert(std::is_trivially_destructible<T>::value,
+		"Arena objects are released without running destructors");
+
+	private:
+	static const size_t CHUNK_SHIFT = 10;
+	static const size_t CHUNK_SIZE = (size_t)1 << CHUNK_SHIFT;
+
+	std::vector<T*>	chunks;
+	size_t			count;
+
+	public:
+	Arena() : chunks(), count(0) {}
+	~Arena() { release(); }
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	Arena(Arena&& other) : chunks(other.chunks), count(other.count)
+	{
+		other.chunks.clear();
+		other.count = 0;
+	}
+
+	Arena& operator=(Arena&& other)
+	{
+		if (this != &other)
+		{
+			release();
+			chunks.swap(other.chunks);
+			count = other.count;
+			other.count = 0;
+		}
+		return (*this);
+	}
+
+	int	allocate(const T& value)
+	{
+		if ((count >> CHUNK_SHIFT) == chunks.size())
+			chunks.push_back(static_cast<T*>(::operator new(CHUNK_SIZE * sizeof(T))));
+		new (&chunks[count >> CHUNK_SHIFT][count & (CHUNK_SIZE - 1)]) T(value);
+		return (count++);
+	}
+
+	T&	operator[](size_t index)
+	{
+		return (chunks[index >> CHUNK_SHIFT][index & (CHUNK_SIZE - 1)]);
+	}
+
+	const T&	operator[](size_t index) const
+	{
+		return (chunks[index >> CHUNK_SHIFT][index & (CHUNK_SIZE - 1)]);
+	}
+
+	size_t	size() const
+	{
+		return (count);
+	}
+
+	void	release()
+	{
+		for (size_t i = 0; i < chunks.size(); i++)
+			::operator delete(chunks[i]);
+		chunks.clear();
+		count = 0;
+	}
+};
+
+#endif
@@ -3,11 +3,39 @@
 
 # include "StringUtils.hpp"
 # include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
 # include <unistd.h>
 # include <fstream>
 
-bool		fileExists(const std::string& path);
-bool		isReadable(const std::string& path);
+/*
+A whole file held read-only in memory: mapped when it is a regular file
+of non-zero size, otherwise read in one pass into an owned buffer. The
+view stays valid for the object's lifetime.
+*/
+class MappedFile {
+	private:
+	void		*_map;
+	size_t		_mapSize;
+	std::string	_buffer;
+
+	void		release();
+
+	public:
+	MappedFile();
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other);
+	MappedFile& operator=(MappedFile&& other);
+
+	std::string_view	view() const;
+};
+
+bool		readAll(int fd, std::string& content, size_t hint);
 std::string	readFile(const std::string& path);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,34 @@
+#ifndef OPTIONS_HPP
+# define OPTIONS_HPP
+
+# include <string>
+# include <stdexcept>
+# include <cstdlib>
+
+struct Options
+{
+	std::string	input;
+	bool		followpos;
+	int			threads;
+	std::string	scan;
+	bool		lazy;
+	size_t		lazyCache;
+	std::string	tables;
+	bool		stdoutOutput;
+	bool		debug;
+	bool		direct;
+	bool		mmap;
+	bool		backupReport;
+	bool		noBackup;
+	bool		simd;
+	bool		keywords;
+	bool		parallel;
+	bool		batch;
+
+	Options();
+};
+
+Options		parseOptions(int argc, char **argv);
+std::string	usage();
+
+#endif
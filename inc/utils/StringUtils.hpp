@@ -2,6 +2,7 @@
 # define STRINGUTILS_HPP
 
 # include <string>
+# include <string_view>
 # include <cstdlib>
 # include <stdexcept>
 # include <sstream>
@@ -11,5 +12,7 @@ std::string					trim(const std::string& str);
 std::vector<std::string>	split(const std::string& str, char delim);
 std::string					toLower(const std::string& str);
 std::string					toUpper(const std::string &str);
+std::string					escape(const std::string &str);
+char						unescapeChar(std::string_view str, size_t &i);
 
 #endif
\ No newline at end of file
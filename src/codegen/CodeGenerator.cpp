@@ -0,0 +1,1099 @@
+#include "../../inc/codegen/CodeGenerator.hpp"
+#include <algorithm>
+#include <cstdio>
+
+GeneratorOptions::GeneratorOptions()
+    :   direct(false), mmap(false), backup(true), simd(true), parallel(false), batch(false) {}
+
+CodeGenerator::CodeGenerator(const ScannerTables& tables, const std::vector<Rule>& rules,
+    const KeywordTable& keywords, const std::string& headerCode, const std::string& userCode,
+    const GeneratorOptions& options)
+    :   tables(tables), rules(rules), keywords(keywords), headerCode(headerCode), userCode(userCode), options(options),
+        skipRanges(tables.getStateCount()) {
+    if (options.simd)
+        findSkipStates();
+}
+
+/*
+A state gets a skip loop when the bytes that keep it in place number at
+least MIN_SKIP_BYTES and form at most MAX_SKIP_RANGES ranges. Byte 0 is
+never part of the loop: it has to stop the skip so the sentinel (or a
+real NUL) goes through the normal path.
+*/
+void CodeGenerator::findSkipStates() {
+    const std::vector<int32_t>& classOf = tables.getClassOf();
+
+    for (int s = 0; s < tables.getStateCount(); s++) {
+        std::vector<std::pair<int, int>> ranges;
+        int count = 0;
+
+        for (int c = 1; c < 256; c++) {
+            if (tables.lookup(s, classOf[c]) != s)
+                continue ;
+            count++;
+            if (!ranges.empty() && ranges.back().second == c - 1)
+                ranges.back().second = c;
+            else
+                ranges.push_back(std::make_pair(c, c));
+        }
+        if (count >= MIN_SKIP_BYTES && (int)ranges.size() <= MAX_SKIP_RANGES)
+            skipRanges[s] = ranges;
+    }
+}
+
+bool CodeGenerator::hasSkipStates() const {
+    for (const auto& ranges : skipRanges) {
+        if (!ranges.empty())
+            return true;
+    }
+    return false;
+}
+
+static const char *elementType(const std::vector<int32_t>& values) {
+    switch (ScannerTables::elementBytes(values)) {
+        case 1: return "int8_t";
+        case 2: return "int16_t";
+        default: return "int32_t";
+    }
+}
+
+void CodeGenerator::emitArray(std::ostream& out, const std::string& name,
+    const std::vector<int32_t>& values) {
+    out << "static const " << elementType(values) << " " << name
+        << "[" << (values.empty() ? 1 : values.size()) << "] = {";
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i % 16 == 0)
+            out << "\n    ";
+        out << values[i] << (i + 1 < values.size() ? ", " : "");
+    }
+    if (values.empty())
+        out << "0";
+    out << "\n};\n\n";
+}
+
+void CodeGenerator::emitPrologue(std::ostream& out) const {
+    out << "/* Generated by ft_lex. */\n"
+        "\n";
+    if (options.mmap)
+        out << "#define YY_USE_MMAP\n"
+            "\n";
+    if (options.parallel)
+        out << "#define YY_PARALLEL\n"
+            "\n";
+    if (options.batch)
+        out << "#define YY_BATCH\n"
+            "\n";
+    out << "#include <stdio.h>\n"
+        "#include <stdlib.h>\n"
+        "#include <string.h>\n"
+        "#include <stdint.h>\n"
+        "#include <unistd.h>\n"
+        "#include <errno.h>\n"
+        "#ifdef YY_USE_MMAP\n"
+        "# include <sys/mman.h>\n"
+        "# include <sys/stat.h>\n"
+        "#endif\n"
+        "#ifdef YY_PARALLEL\n"
+        "# include <pthread.h>\n"
+        "#endif\n"
+        "\n"
+        "FILE *yyin;\n"
+        "FILE *yyout;\n"
+        "char *yytext;\n"
+        "int yyleng;\n"
+        "\n"
+        "#define YY_EOF (-2)\n"
+        "\n"
+        "int yylex(void);\n"
+        "int yynext(const char **yy_text, size_t *yy_length);\n"
+        "int yywrap(void);\n"
+        "#ifdef YY_PARALLEL\n"
+        "typedef void (*yy_token_fn)(int yy_rule, const char *yy_text, size_t yy_length, void *yy_arg);\n"
+        "int yyscan_parallel(const char *yy_data, size_t yy_size, int yy_threads, yy_token_fn yy_emit, void *yy_arg);\n"
+        "#endif\n"
+        "#ifdef YY_BATCH\n"
+        "typedef void (*yy_batch_fn)(int yy_stream, int yy_rule, const char *yy_text, size_t yy_length, void *yy_arg);\n"
+        "void yyscan_batch(const char *const *yy_data, const size_t *yy_sizes, int yy_count,\n"
+        "    yy_batch_fn yy_emit, void *yy_arg);\n"
+        "#endif\n"
+        "\n";
+    if (!headerCode.empty())
+        out << headerCode << (headerCode.back() == '\n' ? "" : "\n") << "\n";
+    out << "#ifndef YY_TERMINATE_YYTEXT\n"
+        "# define YY_TERMINATE_YYTEXT " << (readsYytext() ? 1 : 0) << "\n"
+        "#endif\n"
+        "#ifndef ECHO\n"
+        "# define ECHO fwrite(yytext, (size_t)yyleng, 1, yyout)\n"
+        "#endif\n"
+        "#define yyterminate() return 0\n"
+        "#ifndef YY_BUF_SIZE\n"
+        "# define YY_BUF_SIZE 65536\n"
+        "#endif\n"
+        "/* Readable bytes kept after the sentinel for the vector skip loops. */\n"
+        "#define YY_PAD 32\n"
+        "\n";
+}
+
+void CodeGenerator::emitTables(std::ostream& out) const {
+    if (options.direct)
+        return ;
+    emitArray(out, "yy_ec", tables.getClassOf());
+    emitArray(out, "yy_accept", tables.getAccept());
+    emitArray(out, "yy_nul_trans", tables.getNulTransitions());
+    if (tables.getMode() != TABLES_FULL)
+        emitArray(out, "yy_base", tables.getBase());
+    if (tables.getMode() == TABLES_COMPACT)
+        emitArray(out, "yy_def", tables.getDefault());
+    emitArray(out, "yy_nxt", tables.getNext());
+    if (tables.getMode() != TABLES_FULL)
+        emitArray(out, "yy_chk", tables.getCheck());
+}
+
+/*
+A C string literal for text, using 3-digit octal escapes so a following
+digit can never extend them.
+*/
+static std::string cString(const std::string& text) {
+    std::string result = "\"";
+
+    for (unsigned char c : text) {
+        if (c == '\\' || c == '"')
+            result += std::string("\\") + (char)c;
+        else if (c < 32 || c >= 127 || c == '?') {
+            char octal[5];
+            snprintf(octal, sizeof(octal), "\\%03o", c);
+            result += octal;
+        } else
+            result += (char)c;
+    }
+    return result + "\"";
+}
+
+/*
+The keyword table's slots (text, length, rule; rule -1 when empty), the
+bucket displacements, the hash KeywordTable::hash describes, and
+yy_keyword(), which returns the keyword's rule when the token is a
+keyword that outranks the host rule that matched it.
+*/
+void CodeGenerator::emitKeywords(std::ostream& out) const {
+    if (keywords.isEmpty())
+        return ;
+
+    const std::vector<int32_t>& slots = keywords.getSlots();
+    std::vector<int32_t> lengths(slots.size(), 0);
+    std::vector<int32_t> ruleOf(slots.size(), -1);
+    size_t longest = 0;
+
+    out << "static const char *const yy_kw_text[" << slots.size() << "] = {\n";
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i] < 0) {
+            out << "    0,\n";
+            continue ;
+        }
+        const Keyword& keyword = keywords.getKeywords()[slots[i]];
+        lengths[i] = keyword.text.size();
+        ruleOf[i] = keyword.rule;
+        longest = std::max(longest, keyword.text.size());
+        out << "    " << cString(keyword.text) << ",\n";
+    }
+    out << "};\n\n";
+    emitArray(out, "yy_kw_length", lengths);
+    emitArray(out, "yy_kw_rule", ruleOf);
+    emitArray(out, "yy_kw_disp", keywords.getDisplacements());
+
+    out << "static uint32_t yy_kw_hash(const char *yy_s, size_t yy_n, uint32_t yy_seed)\n"
+        "{\n"
+        "    uint32_t yy_h = (2166136261u ^ yy_seed) + (uint32_t)yy_n;\n"
+        "    size_t yy_i;\n"
+        "\n"
+        "    for (yy_i = 0; yy_i < yy_n; yy_i++) {\n"
+        "        yy_h ^= (unsigned char)yy_s[yy_i];\n"
+        "        yy_h *= 16777619u;\n"
+        "    }\n"
+        "    return yy_h ^ (yy_h >> 15);\n"
+        "}\n"
+        "\n"
+        "static int yy_keyword(const char *yy_s, size_t yy_n, int yy_rule)\n"
+        "{\n"
+        "    uint32_t yy_slot;\n"
+        "\n"
+        "    if (yy_n > " << longest << ")\n"
+        "        return yy_rule;\n"
+        "    yy_slot = yy_kw_hash(yy_s, yy_n, (uint32_t)yy_kw_disp[yy_kw_hash(yy_s, yy_n, 0) & "
+        << keywords.getDisplacements().size() - 1 << "]) & " << slots.size() - 1 << ";\n"
+        "    if (yy_kw_rule[yy_slot] >= 0 && yy_kw_rule[yy_slot] < yy_rule\n"
+        "        && (size_t)yy_kw_length[yy_slot] == yy_n && memcmp(yy_kw_text[yy_slot], yy_s, yy_n) == 0)\n"
+        "        return yy_kw_rule[yy_slot];\n"
+        "    return yy_rule;\n"
+        "}\n"
+        "\n";
+}
+
+/*
+After a match from yy_start to yy_last, replaces a host rule by the
+keyword the token spells, if any.
+*/
+void CodeGenerator::emitKeywordCheck(std::ostream& out, int depth) const {
+    std::string indent(depth * 4, ' ');
+
+    if (keywords.isEmpty())
+        return ;
+    out << indent << "if (";
+    for (size_t i = 0; i < keywords.getHosts().size(); i++)
+        out << (i ? " || " : "") << "yy_rule == " << keywords.getHosts()[i];
+    out << ")\n"
+        << indent << "    yy_rule = yy_keyword(yy_start, (size_t)(yy_last - yy_start), yy_rule);\n";
+}
+
+/*
+Input is read with read(2) in blocks of YY_BUF_SIZE into a buffer whose
+valid data is always followed by a NUL sentinel at yy_end. The sentinel
+jams every state, so the scan loop never compares against the end of the
+buffer: only on a jam does it check whether it stopped on the sentinel
+and needs a refill. A refill moves just the unfinished token to the front
+(doubling the buffer when the token fills it), so yytext stays contiguous.
+
+Under YY_USE_MMAP a regular file is instead mapped whole, with a zero page
+behind it standing in for the sentinel; the scan then runs in place and
+the first sentinel it meets is the end of input.
+*/
+void CodeGenerator::emitInput(std::ostream& out) const {
+    out << "static char *yy_buf;\n"
+        "static size_t yy_size;\n"
+        "static char *yy_pos;\n"
+        "static char *yy_end;\n"
+        "static int yy_eof;\n"
+        "#if YY_TERMINATE_YYTEXT\n"
+        "static char yy_hold;\n"
+        "static char *yy_hold_at;\n"
+        "#endif\n"
+        "\n"
+        "static void yy_fatal(const char *yy_message)\n"
+        "{\n"
+        "    fprintf(stderr, \"ft_lex scanner: %s\\n\", yy_message);\n"
+        "    exit(2);\n"
+        "}\n"
+        "\n"
+        "#ifdef YY_USE_MMAP\n"
+        "static char *yy_map_at;\n"
+        "static size_t yy_map_size;\n"
+        "static int yy_fresh = 1;\n"
+        "# define YY_NEW_INPUT() (yy_eof = 0, yy_fresh = 1)\n"
+        "\n"
+        "/*\n"
+        " * Maps a regular, unread yyin over an anonymous mapping one page longer,\n"
+        " * so the byte after its end is a zero sentinel. 0 if it cannot be mapped.\n"
+        " */\n"
+        "static int yy_map(void)\n"
+        "{\n"
+        "    struct stat yy_st;\n"
+        "    size_t yy_page = (size_t)sysconf(_SC_PAGESIZE);\n"
+        "    int yy_fd = fileno(yyin);\n"
+        "    char *yy_at;\n"
+        "\n"
+        "    if (fstat(yy_fd, &yy_st) < 0 || !S_ISREG(yy_st.st_mode) || yy_st.st_size == 0\n"
+        "        || lseek(yy_fd, 0, SEEK_CUR) != 0)\n"
+        "        return 0;\n"
+        "    yy_map_size = (((size_t)yy_st.st_size + YY_PAD) / yy_page + 1) * yy_page;\n"
+        "    yy_at = (char *)mmap(NULL, yy_map_size, PROT_READ | PROT_WRITE,\n"
+        "        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);\n"
+        "    if (yy_at == MAP_FAILED)\n"
+        "        return 0;\n"
+        "    if (mmap(yy_at, (size_t)yy_st.st_size, PROT_READ | PROT_WRITE,\n"
+        "        MAP_PRIVATE | MAP_FIXED, yy_fd, 0) == MAP_FAILED) {\n"
+        "        munmap(yy_at, yy_map_size);\n"
+        "        return 0;\n"
+        "    }\n"
+        "    madvise(yy_at, yy_map_size, MADV_SEQUENTIAL);\n"
+        "    yy_map_at = yy_at;\n"
+        "    yy_pos = yy_at;\n"
+        "    yy_end = yy_at + yy_st.st_size;\n"
+        "    yy_eof = 1;\n"
+        "    return 1;\n"
+        "}\n"
+        "#else\n"
+        "# define YY_NEW_INPUT() (yy_eof = 0)\n"
+        "#endif\n"
+        "\n"
+        "/* Moves the unscanned bytes to the front and reads more; 0 at end of input. */\n"
+        "static int yy_fill(void)\n"
+        "{\n"
+        "    size_t yy_keep;\n"
+        "    ssize_t yy_got = 0;\n"
+        "\n"
+        "#ifdef YY_USE_MMAP\n"
+        "    if (yy_map_at) {\n"
+        "        if (yy_eof)\n"
+        "            return 0;\n"
+        "        munmap(yy_map_at, yy_map_size);\n"
+        "        yy_map_at = NULL;\n"
+        "        yy_pos = yy_end = yy_buf;\n"
+        "    }\n"
+        "    if (yy_fresh) {\n"
+        "        yy_fresh = 0;\n"
+        "        if (yy_map())\n"
+        "            return 1;\n"
+        "    }\n"
+        "#endif\n"
+        "    yy_keep = (size_t)(yy_end - yy_pos);\n"
+        "    if (yy_keep && yy_pos != yy_buf)\n"
+        "        memmove(yy_buf, yy_pos, yy_keep);\n"
+        "    if (yy_keep >= yy_size) {\n"
+        "        yy_size = yy_size ? yy_size * 2 : YY_BUF_SIZE;\n"
+        "        yy_buf = (char *)realloc(yy_buf, yy_size + 2 + YY_PAD);\n"
+        "        if (!yy_buf)\n"
+        "            yy_fatal(\"out of memory\");\n"
+        "    }\n"
+        "    yy_pos = yy_buf;\n"
+        "    yy_end = yy_buf + yy_keep;\n"
+        "    if (!yy_eof) {\n"
+        "        do\n"
+        "            yy_got = read(fileno(yyin), yy_end, yy_size - yy_keep);\n"
+        "        while (yy_got < 0 && errno == EINTR);\n"
+        "        if (yy_got < 0)\n"
+        "            yy_fatal(\"input failed\");\n"
+        "        if (yy_got == 0)\n"
+        "            yy_eof = 1;\n"
+        "        yy_end += yy_got;\n"
+        "    }\n"
+        "    *yy_end = '\\0';\n"
+        "    return yy_got > 0;\n"
+        "}\n"
+        "\n"
+        "/* Refills when the scan reaches yy_end, keeping the token's pointers valid. */\n"
+        "#define YY_MORE(yy_ok) do { \\\n"
+        "        size_t yy_scanned = (size_t)(yy_cp - yy_start); \\\n"
+        "        size_t yy_matched = (size_t)(yy_last - yy_start); \\\n"
+        "        yy_pos = yy_start; \\\n"
+        "        yy_ok = yy_fill(); \\\n"
+        "        yy_start = yy_pos; \\\n"
+        "        yy_cp = yy_start + yy_scanned; \\\n"
+        "        yy_last = yy_start + yy_matched; \\\n"
+        "    } while (0)\n"
+        "\n";
+}
+
+/*
+Sets yy_next to the successor of yy_state on the byte at yy_cp, or -1,
+in the selected table layout.
+*/
+void CodeGenerator::emitTransition(std::ostream& out, int depth) const {
+    std::string indent(depth * 4, ' ');
+    const char *input = "yy_ec[(unsigned char)*yy_cp]";
+
+    switch (tables.getMode()) {
+        case TABLES_FULL:
+            out << indent << "yy_next = yy_nxt[yy_state * " << tables.getWidth() << " + " << input << "];\n";
+            break ;
+        case TABLES_COMB:
+            out << indent << "yy_c = yy_base[yy_state] + " << input << ";\n"
+                << indent << "yy_next = yy_chk[yy_c] == yy_state ? yy_nxt[yy_c] : -1;\n";
+            break ;
+        case TABLES_COMPACT:
+            out << indent << "yy_c = " << input << ";\n"
+                << indent << "yy_next = yy_state;\n"
+                << indent << "while (yy_chk[yy_base[yy_next] + yy_c] != yy_next && (yy_next = yy_def[yy_next]) >= 0)\n"
+                << indent << "    ;\n"
+                << indent << "if (yy_next >= 0)\n"
+                << indent << "    yy_next = yy_nxt[yy_base[yy_next] + yy_c];\n";
+            break ;
+    }
+}
+
+void CodeGenerator::emitTableMatch(std::ostream& out) const {
+    out << "    yy_state = 0;\n"
+        "    for (;;) {\n";
+    emitTransition(out, 2);
+    out << "        if (yy_next < 0) {\n"
+        "            if (*yy_cp != '\\0')\n"
+        "                break;\n"
+        "            if (yy_cp == yy_end) {\n"
+        "                YY_MORE(yy_more);\n"
+        "                if (!yy_more)\n"
+        "                    break;\n"
+        "                continue;\n"
+        "            }\n"
+        "            yy_next = yy_nul_trans[yy_state];\n"
+        "            if (yy_next < 0)\n"
+        "                break;\n"
+        "        }\n";
+    if (hasSkipStates())
+        out << "        if (yy_next == yy_state) {\n"
+            "            yy_cp = yy_skip(yy_state, yy_cp + 1);\n"
+            "        } else {\n"
+            "            yy_state = yy_next;\n"
+            "            yy_cp++;\n"
+            "        }\n";
+    else
+        out << "        yy_state = yy_next;\n"
+            "        yy_cp++;\n";
+    if (options.backup)
+        out << "        if (yy_accept[yy_state] >= 0) {\n"
+            "            yy_rule = yy_accept[yy_state];\n"
+            "            yy_last = yy_cp;\n"
+            "        }\n"
+            "    }\n";
+    else
+        out << "    }\n"
+            "    yy_rule = yy_accept[yy_state];\n"
+            "    yy_last = yy_cp;\n";
+}
+
+/*
+Emits a binary search over the byte runs of one state, re2c style. Byte 0
+is always a run of its own: it is the buffer sentinel, so its leaf first
+checks for the end of the buffered data and, after a refill, re-enters
+the state. Without backing up, a jam sets the state's rule on the way out.
+*/
+void CodeGenerator::emitBranches(std::ostream& out, const std::vector<ByteRange>& ranges,
+    size_t begin, size_t end, int state, int depth) const {
+    std::string indent(depth * 4, ' ');
+    std::string jam = "goto yy_done;";
+
+    if (!options.backup && tables.getAccept()[state] >= 0)
+        jam = "{ yy_rule = " + std::to_string(tables.getAccept()[state]) + "; goto yy_done; }";
+    if (end - begin == 1) {
+        if (ranges[begin].last == 0)
+            out << indent << "if (yy_cp == yy_end) {\n"
+                << indent << "    YY_MORE(yy_more);\n"
+                << indent << "    if (!yy_more)\n"
+                << indent << "        " << jam << "\n"
+                << indent << "    goto yy_s" << state << ";\n"
+                << indent << "}\n";
+        if (ranges[begin].target < 0)
+            out << indent << jam << "\n";
+        else if (ranges[begin].target == state && !skipRanges[state].empty())
+            out << indent << "yy_cp = yy_skip_" << state << "(yy_cp + 1);\n" << indent << "goto yy_s" << state << ";\n";
+        else
+            out << indent << "yy_cp++;\n" << indent << "goto yy_s" << ranges[begin].target << ";\n";
+        return ;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    out << indent << "if (yych <= " << ranges[mid - 1].last << ") {\n";
+    emitBranches(out, ranges, begin, mid, state, depth + 1);
+    out << indent << "} else {\n";
+    emitBranches(out, ranges, mid, end, state, depth + 1);
+    out << indent << "}\n";
+}
+
+/*
+Each DFA state becomes a labelled block: record the accept if it has one,
+then branch on the byte and goto the successor. The runs of bytes with
+the same successor (-1 for none) come from the scanner tables.
+*/
+void CodeGenerator::emitDirectMatch(std::ostream& out) const {
+    const std::vector<int32_t>& classOf = tables.getClassOf();
+    std::vector<std::vector<ByteRange>> states(tables.getStateCount());
+
+    for (int s = 0; s < tables.getStateCount(); s++) {
+        states[s].push_back({ 0, tables.getNulTransitions()[s] });
+        for (int c = 1; c < 256; c++) {
+            int target = tables.lookup(s, classOf[c]);
+            if (c > 1 && states[s].back().target == target)
+                states[s].back().last = c;
+            else
+                states[s].push_back({ c, target });
+        }
+    }
+
+    for (int s = 0; s < tables.getStateCount(); s++) {
+        out << "yy_s" << s << ":\n";
+        if (options.backup && tables.getAccept()[s] >= 0)
+            out << "    yy_rule = " << tables.getAccept()[s] << ";\n"
+                "    yy_last = yy_cp;\n";
+        out << "    yych = (unsigned char)*yy_cp;\n";
+        emitBranches(out, states[s], 0, states[s].size(), s, 1);
+    }
+    out << "yy_done:\n";
+    if (!options.backup)
+        out << "    yy_last = yy_cp;\n";
+}
+
+/*
+One yy_skip_N() per looping state: returns the first byte at or after p
+that leaves the loop. A byte b is inside [lo, hi] when (b - lo) wraps to
+at most hi - lo, which min_epu8 + cmpeq tests on 32 (AVX2) or 16 (SSE2)
+bytes at once; movemask and ctz then find the first outsider. The scalar
+loop is the fallback, and can be forced with -DYY_NO_SIMD. The vector
+loads may read up to YY_PAD bytes past the sentinel, which stops them.
+*/
+void CodeGenerator::emitSkipKernels(std::ostream& out) const {
+    if (!hasSkipStates())
+        return ;
+
+    out << "#if !defined(YY_NO_SIMD) && defined(__GNUC__) && defined(__AVX2__)\n"
+        "# include <immintrin.h>\n"
+        "# define YY_SKIP_AVX2\n"
+        "#elif !defined(YY_NO_SIMD) && defined(__GNUC__) && defined(__SSE2__)\n"
+        "# include <emmintrin.h>\n"
+        "# define YY_SKIP_SSE2\n"
+        "#endif\n"
+        "\n"
+        "#define YY_IN_RANGE(yy_b, yy_lo, yy_hi) ((unsigned char)((yy_b) - (yy_lo)) <= (yy_hi) - (yy_lo))\n"
+        "\n";
+
+    for (int s = 0; s < tables.getStateCount(); s++) {
+        const std::vector<std::pair<int, int>>& ranges = skipRanges[s];
+        if (ranges.empty())
+            continue ;
+
+        out << "/* State " << s << " loops on";
+        for (const auto& range : ranges)
+            out << " " << range.first << "-" << range.second;
+        out << ". */\n"
+            "static inline char *yy_skip_" << s << "(char *yy_p)\n"
+            "{\n";
+        const char *vector[2][6] = {
+            { "YY_SKIP_AVX2", "__m256i", "_mm256_", "si256", "32", "uint32_t" },
+            { "YY_SKIP_SSE2", "__m128i", "_mm_", "si128", "16", "uint32_t" },
+        };
+        for (int v = 0; v < 2; v++) {
+            std::string type = vector[v][1];
+            std::string mm = vector[v][2];
+
+            out << (v == 0 ? "#if defined(" : "#elif defined(") << vector[v][0] << ")\n";
+            for (size_t i = 0; i < ranges.size(); i++)
+                out << "    const " << type << " yy_lo" << i << " = " << mm << "set1_epi8((char)" << ranges[i].first << ");\n"
+                    "    const " << type << " yy_span" << i << " = " << mm << "set1_epi8((char)"
+                    << ranges[i].second - ranges[i].first << ");\n";
+            out << "\n"
+                "    for (;;) {\n"
+                "        " << type << " yy_v = " << mm << "loadu_" << vector[v][3] << "((const " << type << " *)yy_p);\n"
+                "        " << type << " yy_in = " << mm << "setzero_" << vector[v][3] << "();\n"
+                "        " << vector[v][5] << " yy_out;\n"
+                "\n";
+            for (size_t i = 0; i < ranges.size(); i++)
+                out << "        {\n"
+                    "            " << type << " yy_d = " << mm << "sub_epi8(yy_v, yy_lo" << i << ");\n"
+                    "            yy_in = " << mm << "or_" << vector[v][3] << "(yy_in, " << mm << "cmpeq_epi8("
+                    << mm << "min_epu8(yy_d, yy_span" << i << "), yy_d));\n"
+                    "        }\n";
+            out << "        yy_out = ~(" << vector[v][5] << ")" << mm << "movemask_epi8(yy_in)"
+                << (v == 1 ? " & 0xffffu" : "") << ";\n"
+                "        if (yy_out)\n"
+                "            return yy_p + __builtin_ctz(yy_out);\n"
+                "        yy_p += " << vector[v][4] << ";\n"
+                "    }\n";
+        }
+        out << "#else\n"
+            "    for (;;) {\n"
+            "        unsigned char yy_b = (unsigned char)*yy_p;\n"
+            "\n"
+            "        if (!(";
+        for (size_t i = 0; i < ranges.size(); i++)
+            out << (i ? "\n            || " : "") << "YY_IN_RANGE(yy_b, " << ranges[i].first << ", " << ranges[i].second << ")";
+        out << "))\n"
+            "            return yy_p;\n"
+            "        yy_p++;\n"
+            "    }\n"
+            "#endif\n"
+            "}\n"
+            "\n";
+    }
+
+    if (options.direct)
+        return ;
+    out << "static inline char *yy_skip(int yy_state, char *yy_p)\n"
+        "{\n"
+        "    switch (yy_state) {\n";
+    for (int s = 0; s < tables.getStateCount(); s++) {
+        if (!skipRanges[s].empty())
+            out << "    case " << s << ": return yy_skip_" << s << "(yy_p);\n";
+    }
+    out << "    default: return yy_p;\n"
+        "    }\n"
+        "}\n"
+        "\n";
+}
+
+/*
+yy_match() finds the next token and is shared by yylex(), which runs the
+actions, and yynext(), which only hands back the rule and a view of the
+text. yytext always points into the input buffer; the byte after it is
+swapped for a NUL only when YY_TERMINATE_YYTEXT is set.
+*/
+void CodeGenerator::emitScanner(std::ostream& out) const {
+    out << "/* The next token's rule, -1 for an unmatched byte, or YY_EOF; sets yytext and yyleng. */\n"
+        "static int yy_match(void)\n"
+        "{\n";
+    if (options.direct)
+        out << "    unsigned char yych;\n";
+    else
+        out << "    int yy_state;\n"
+            "    int yy_next;\n"
+            "    int yy_c;\n";
+    out << "    int yy_rule;\n"
+        "    int yy_more;\n"
+        "    char *yy_start;\n"
+        "    char *yy_cp;\n"
+        "    char *yy_last;\n"
+        "\n";
+    if (!options.direct)
+        out << "    (void)yy_c;\n";
+    out << "    if (!yyin)\n"
+        "        yyin = stdin;\n"
+        "#if YY_TERMINATE_YYTEXT\n"
+        "    if (yy_hold_at) {\n"
+        "        *yy_hold_at = yy_hold;\n"
+        "        yy_hold_at = NULL;\n"
+        "    }\n"
+        "#endif\n"
+        "    while (yy_pos == yy_end && !yy_fill()) {\n"
+        "        if (yywrap())\n"
+        "            return YY_EOF;\n"
+        "        YY_NEW_INPUT();\n"
+        "    }\n"
+        "    yy_start = yy_pos;\n"
+        "    yy_cp = yy_start;\n"
+        "    yy_last = yy_start;\n"
+        "    yy_rule = -1;\n";
+    if (options.direct)
+        emitDirectMatch(out);
+    else
+        emitTableMatch(out);
+    out << "    if (yy_last == yy_start) {\n"
+        "        yy_rule = -1;\n"
+        "        yy_last = yy_start + 1;\n"
+        "    }\n";
+    emitKeywordCheck(out, 1);
+    out << "    yytext = yy_start;\n"
+        "    yyleng = (int)(yy_last - yy_start);\n"
+        "    yy_pos = yy_last;\n"
+        "#if YY_TERMINATE_YYTEXT\n"
+        "    yy_hold = *yy_pos;\n"
+        "    yy_hold_at = yy_pos;\n"
+        "    *yy_pos = '\\0';\n"
+        "#endif\n"
+        "    return yy_rule;\n"
+        "}\n"
+        "\n"
+        "int yylex(void)\n"
+        "{\n"
+        "    if (!yyout)\n"
+        "        yyout = stdout;\n"
+        "    for (;;) {\n"
+        "        int yy_rule = yy_match();\n"
+        "\n"
+        "        if (yy_rule == YY_EOF)\n"
+        "            return 0;\n";
+    emitActions(out);
+    out << "    }\n"
+        "}\n"
+        "\n"
+        "/*\n"
+        " * Token API: the next token's rule (-1 for an unmatched byte, YY_EOF at\n"
+        " * the end) and its text, without running any action. The text stays in\n"
+        " * the input buffer and is valid until the next call.\n"
+        " */\n"
+        "int yynext(const char **yy_text, size_t *yy_length)\n"
+        "{\n"
+        "    int yy_rule = yy_match();\n"
+        "\n"
+        "    *yy_text = yy_rule == YY_EOF ? NULL : yytext;\n"
+        "    *yy_length = yy_rule == YY_EOF ? 0 : (size_t)yyleng;\n"
+        "    return yy_rule;\n"
+        "}\n"
+        "\n"
+        "#ifdef __cplusplus\n"
+        "# include <string_view>\n"
+        "\n"
+        "struct yy_token {\n"
+        "    int rule;\n"
+        "    std::string_view text;\n"
+        "};\n"
+        "\n"
+        "static inline yy_token yynext_token()\n"
+        "{\n"
+        "    const char *yy_text;\n"
+        "    size_t yy_length;\n"
+        "    int yy_rule = yynext(&yy_text, &yy_length);\n"
+        "\n"
+        "    return yy_token{ yy_rule, std::string_view(yy_text, yy_length) };\n"
+        "}\n"
+        "#endif\n"
+        "\n";
+}
+
+/*
+True when any user code may read yytext as a C string, so the generated
+scanner has to NUL-terminate it by default.
+*/
+bool CodeGenerator::readsYytext() const {
+    if (headerCode.find("yytext") != std::string::npos || userCode.find("yytext") != std::string::npos)
+        return true;
+    for (const Rule& rule : rules) {
+        if (rule.action.find("yytext") != std::string::npos)
+            return true;
+    }
+    return false;
+}
+
+/*
+yyscan_parallel() tokenizes a whole in-memory buffer on several threads.
+The buffer is cut into rounds of one chunk per thread (at most
+YY_PARALLEL_CHUNK bytes each). Every chunk is scanned speculatively as if
+a token started at its first byte; the true first token start is only
+known once the previous chunk is done, and may lie a few bytes further.
+From there the caller's thread rescans token by token until it reaches a
+start the speculative scan also found: every token after that point is
+the same, since each token is matched from the start state. Chunks are
+stitched and handed to yy_emit in order while later ones still run.
+
+Matches never look past the end of the buffer, so no sentinel or padding
+is needed. Tokens are reported with the same rules as yynext(), -1 for an
+unmatched byte; actions are not run. Returns 0, or -1 with errno set.
+*/
+void CodeGenerator::emitParallel(std::ostream& out) const {
+    if (options.direct)
+        return ;
+    out << "#ifdef YY_PARALLEL\n"
+        "\n"
+        "#ifndef YY_PARALLEL_CHUNK\n"
+        "# define YY_PARALLEL_CHUNK (1 << 24)\n"
+        "#endif\n"
+        "\n"
+        "typedef struct yy_ptoken {\n"
+        "    size_t yy_offset;\n"
+        "    size_t yy_length;\n"
+        "    int yy_rule;\n"
+        "} yy_ptoken;\n"
+        "\n"
+        "typedef struct yy_chunk {\n"
+        "    const char *yy_data;\n"
+        "    size_t yy_size;\n"
+        "    size_t yy_end;\n"
+        "    size_t yy_at;\n"
+        "    yy_ptoken *yy_tokens;\n"
+        "    size_t yy_count;\n"
+        "    size_t yy_cap;\n"
+        "    int yy_error;\n"
+        "    int yy_joinable;\n"
+        "    pthread_t yy_thread;\n"
+        "} yy_chunk;\n"
+        "\n"
+        "/* Longest match at yy_data + yy_at; the token's length, at least 1. */\n"
+        "static size_t yy_match_at(const char *yy_data, size_t yy_size, size_t yy_at, int *yy_rule_out)\n"
+        "{\n"
+        "    const char *yy_start = yy_data + yy_at;\n"
+        "    const char *yy_end = yy_data + yy_size;\n"
+        "    const char *yy_cp = yy_start;\n"
+        "    const char *yy_last = yy_start;\n"
+        "    int yy_state = 0;\n"
+        "    int yy_next;\n"
+        "    int yy_c;\n"
+        "    int yy_rule = -1;\n"
+        "\n"
+        "    (void)yy_c;\n"
+        "    while (yy_cp < yy_end) {\n";
+    emitTransition(out, 2);
+    out << "        if (yy_next < 0 && *yy_cp == '\\0')\n"
+        "            yy_next = yy_nul_trans[yy_state];\n"
+        "        if (yy_next < 0)\n"
+        "            break;\n"
+        "        yy_state = yy_next;\n"
+        "        yy_cp++;\n"
+        "        if (yy_accept[yy_state] >= 0) {\n"
+        "            yy_rule = yy_accept[yy_state];\n"
+        "            yy_last = yy_cp;\n"
+        "        }\n"
+        "    }\n"
+        "    if (yy_last == yy_start) {\n"
+        "        yy_rule = -1;\n"
+        "        yy_last = yy_start + 1;\n"
+        "    }\n";
+    emitKeywordCheck(out, 1);
+    out << "    *yy_rule_out = yy_rule;\n"
+        "    return (size_t)(yy_last - yy_start);\n"
+        "}\n"
+        "\n"
+        "static int yy_push(yy_chunk *yy_c, size_t yy_offset, size_t yy_length, int yy_rule)\n"
+        "{\n"
+        "    if (yy_c->yy_count == yy_c->yy_cap) {\n"
+        "        size_t yy_cap = yy_c->yy_cap ? yy_c->yy_cap * 2 : 1024;\n"
+        "        yy_ptoken *yy_tokens = (yy_ptoken *)realloc(yy_c->yy_tokens, yy_cap * sizeof(yy_ptoken));\n"
+        "\n"
+        "        if (!yy_tokens) {\n"
+        "            yy_c->yy_error = ENOMEM;\n"
+        "            return 0;\n"
+        "        }\n"
+        "        yy_c->yy_tokens = yy_tokens;\n"
+        "        yy_c->yy_cap = yy_cap;\n"
+        "    }\n"
+        "    yy_c->yy_tokens[yy_c->yy_count].yy_offset = yy_offset;\n"
+        "    yy_c->yy_tokens[yy_c->yy_count].yy_length = yy_length;\n"
+        "    yy_c->yy_tokens[yy_c->yy_count].yy_rule = yy_rule;\n"
+        "    yy_c->yy_count++;\n"
+        "    return 1;\n"
+        "}\n"
+        "\n"
+        "/* Speculative scan of one chunk: every token starting before its end. */\n"
+        "static void *yy_scan_chunk(void *yy_arg)\n"
+        "{\n"
+        "    yy_chunk *yy_c = (yy_chunk *)yy_arg;\n"
+        "    size_t yy_at = yy_c->yy_at;\n"
+        "\n"
+        "    while (yy_at < yy_c->yy_end) {\n"
+        "        int yy_rule;\n"
+        "        size_t yy_length = yy_match_at(yy_c->yy_data, yy_c->yy_size, yy_at, &yy_rule);\n"
+        "\n"
+        "        if (!yy_push(yy_c, yy_at, yy_length, yy_rule))\n"
+        "            break;\n"
+        "        yy_at += yy_length;\n"
+        "    }\n"
+        "    return NULL;\n"
+        "}\n"
+        "\n"
+        "/*\n"
+        "Rescans yy_c from the true token start *yy_pos into yy_fix until a\n"
+        "start matches a speculative one; returns the index of that token.\n"
+        "*/\n"
+        "static size_t yy_stitch(yy_chunk *yy_c, yy_chunk *yy_fix, size_t *yy_pos)\n"
+        "{\n"
+        "    size_t yy_i = 0;\n"
+        "\n"
+        "    yy_fix->yy_count = 0;\n"
+        "    for (;;) {\n"
+        "        int yy_rule;\n"
+        "        size_t yy_length;\n"
+        "\n"
+        "        while (yy_i < yy_c->yy_count && yy_c->yy_tokens[yy_i].yy_offset < *yy_pos)\n"
+        "            yy_i++;\n"
+        "        if (*yy_pos >= yy_c->yy_end || (yy_i < yy_c->yy_count && yy_c->yy_tokens[yy_i].yy_offset == *yy_pos))\n"
+        "            return yy_i;\n"
+        "        yy_length = yy_match_at(yy_c->yy_data, yy_c->yy_size, *yy_pos, &yy_rule);\n"
+        "        if (!yy_push(yy_fix, *yy_pos, yy_length, yy_rule))\n"
+        "            return yy_c->yy_count;\n"
+        "        *yy_pos += yy_length;\n"
+        "    }\n"
+        "}\n"
+        "\n"
+        "static void yy_emit_tokens(const char *yy_data, const yy_ptoken *yy_tokens, size_t yy_count,\n"
+        "    yy_token_fn yy_emit, void *yy_arg, size_t *yy_pos)\n"
+        "{\n"
+        "    size_t yy_i;\n"
+        "\n"
+        "    for (yy_i = 0; yy_i < yy_count; yy_i++)\n"
+        "        yy_emit(yy_tokens[yy_i].yy_rule, yy_data + yy_tokens[yy_i].yy_offset, yy_tokens[yy_i].yy_length, yy_arg);\n"
+        "    if (yy_count)\n"
+        "        *yy_pos = yy_tokens[yy_count - 1].yy_offset + yy_tokens[yy_count - 1].yy_length;\n"
+        "}\n"
+        "\n"
+        "int yyscan_parallel(const char *yy_data, size_t yy_size, int yy_threads, yy_token_fn yy_emit, void *yy_arg)\n"
+        "{\n"
+        "    yy_chunk *yy_chunks;\n"
+        "    yy_chunk yy_fix;\n"
+        "    size_t yy_pos = 0;\n"
+        "    int yy_error = 0;\n"
+        "    int yy_k;\n"
+        "\n"
+        "    if (yy_threads < 1)\n"
+        "        yy_threads = 1;\n"
+        "    yy_chunks = (yy_chunk *)calloc((size_t)yy_threads, sizeof(yy_chunk));\n"
+        "    if (!yy_chunks) {\n"
+        "        errno = ENOMEM;\n"
+        "        return -1;\n"
+        "    }\n"
+        "    memset(&yy_fix, 0, sizeof(yy_fix));\n"
+        "    yy_fix.yy_data = yy_data;\n"
+        "    yy_fix.yy_size = yy_size;\n"
+        "    while (yy_pos < yy_size && !yy_error) {\n"
+        "        size_t yy_chunk_size = (yy_size - yy_pos + (size_t)yy_threads - 1) / (size_t)yy_threads;\n"
+        "        int yy_used = 0;\n"
+        "\n"
+        "        if (yy_chunk_size > YY_PARALLEL_CHUNK)\n"
+        "            yy_chunk_size = YY_PARALLEL_CHUNK;\n"
+        "        for (yy_k = 0; yy_k < yy_threads && yy_pos + (size_t)yy_k * yy_chunk_size < yy_size; yy_k++) {\n"
+        "            yy_chunk *yy_c = &yy_chunks[yy_k];\n"
+        "\n"
+        "            yy_c->yy_data = yy_data;\n"
+        "            yy_c->yy_size = yy_size;\n"
+        "            yy_c->yy_at = yy_pos + (size_t)yy_k * yy_chunk_size;\n"
+        "            yy_c->yy_end = yy_size - yy_c->yy_at > yy_chunk_size ? yy_c->yy_at + yy_chunk_size : yy_size;\n"
+        "            yy_c->yy_count = 0;\n"
+        "            yy_c->yy_joinable = yy_k > 0 && pthread_create(&yy_c->yy_thread, NULL, yy_scan_chunk, yy_c) == 0;\n"
+        "            yy_used++;\n"
+        "        }\n"
+        "        for (yy_k = 0; yy_k < yy_used; yy_k++) {\n"
+        "            yy_chunk *yy_c = &yy_chunks[yy_k];\n"
+        "            size_t yy_first = 0;\n"
+        "\n"
+        "            /* the first chunk, and any a thread could not be started for, run here */\n"
+        "            if (yy_c->yy_joinable)\n"
+        "                pthread_join(yy_c->yy_thread, NULL);\n"
+        "            else\n"
+        "                yy_scan_chunk(yy_c);\n"
+        "            if (yy_k > 0 && !yy_error) {\n"
+        "                yy_first = yy_stitch(yy_c, &yy_fix, &yy_pos);\n"
+        "                yy_emit_tokens(yy_data, yy_fix.yy_tokens, yy_fix.yy_count, yy_emit, yy_arg, &yy_pos);\n"
+        "            }\n"
+        "            if (yy_c->yy_error || yy_fix.yy_error)\n"
+        "                yy_error = yy_c->yy_error ? yy_c->yy_error : yy_fix.yy_error;\n"
+        "            if (!yy_error)\n"
+        "                yy_emit_tokens(yy_data, yy_c->yy_tokens + yy_first, yy_c->yy_count - yy_first,\n"
+        "                    yy_emit, yy_arg, &yy_pos);\n"
+        "        }\n"
+        "    }\n"
+        "    for (yy_k = 0; yy_k < yy_threads; yy_k++)\n"
+        "        free(yy_chunks[yy_k].yy_tokens);\n"
+        "    free(yy_chunks);\n"
+        "    free(yy_fix.yy_tokens);\n"
+        "    if (yy_error) {\n"
+        "        errno = yy_error;\n"
+        "        return -1;\n"
+        "    }\n"
+        "    return 0;\n"
+        "}\n"
+        "\n"
+        "#endif\n"
+        "\n";
+}
+
+/*
+yyscan_batch() tokenizes many short in-memory streams by running
+YY_BATCH_LANES scanners side by side: each pass of the outer loop moves
+every lane one byte. The lanes' table loads do not depend on each other,
+so their cache misses overlap instead of adding up. A lane that finishes
+its stream picks up the next one. yy_emit gets the stream index with
+every token; tokens of one stream arrive in order, interleaved with those
+of other streams. Rules are as for yynext(), and no actions are run.
+*/
+void CodeGenerator::emitBatch(std::ostream& out) const {
+    if (options.direct)
+        return ;
+    out << "#ifdef YY_BATCH\n"
+        "\n"
+        "#ifndef YY_BATCH_LANES\n"
+        "# define YY_BATCH_LANES 8\n"
+        "#endif\n"
+        "\n"
+        "typedef struct yy_lane {\n"
+        "    const char *yy_start;\n"
+        "    const char *yy_cp;\n"
+        "    const char *yy_last;\n"
+        "    const char *yy_end;\n"
+        "    int yy_state;\n"
+        "    int yy_rule;\n"
+        "    int yy_stream;\n"
+        "} yy_lane;\n"
+        "\n"
+        "static void yy_lane_begin(yy_lane *yy_p, const char *yy_at)\n"
+        "{\n"
+        "    yy_p->yy_start = yy_at;\n"
+        "    yy_p->yy_cp = yy_at;\n"
+        "    yy_p->yy_last = yy_at;\n"
+        "    yy_p->yy_state = 0;\n"
+        "    yy_p->yy_rule = -1;\n"
+        "}\n"
+        "\n"
+        "/* Gives the lane the next non-empty stream; 0 when there is none left. */\n"
+        "static int yy_lane_load(yy_lane *yy_p, const char *const *yy_data, const size_t *yy_sizes,\n"
+        "    int yy_count, int *yy_queued)\n"
+        "{\n"
+        "    while (*yy_queued < yy_count && yy_sizes[*yy_queued] == 0)\n"
+        "        (*yy_queued)++;\n"
+        "    if (*yy_queued == yy_count) {\n"
+        "        yy_p->yy_stream = -1;\n"
+        "        return 0;\n"
+        "    }\n"
+        "    yy_p->yy_stream = *yy_queued;\n"
+        "    yy_p->yy_end = yy_data[*yy_queued] + yy_sizes[*yy_queued];\n"
+        "    yy_lane_begin(yy_p, yy_data[*yy_queued]);\n"
+        "    (*yy_queued)++;\n"
+        "    return 1;\n"
+        "}\n"
+        "\n"
+        "void yyscan_batch(const char *const *yy_data, const size_t *yy_sizes, int yy_count,\n"
+        "    yy_batch_fn yy_emit, void *yy_arg)\n"
+        "{\n"
+        "    yy_lane yy_lanes[YY_BATCH_LANES];\n"
+        "    int yy_queued = 0;\n"
+        "    int yy_active = 0;\n"
+        "    int yy_l;\n"
+        "\n"
+        "    for (yy_l = 0; yy_l < YY_BATCH_LANES; yy_l++)\n"
+        "        yy_active += yy_lane_load(&yy_lanes[yy_l], yy_data, yy_sizes, yy_count, &yy_queued);\n"
+        "    while (yy_active) {\n"
+        "        for (yy_l = 0; yy_l < YY_BATCH_LANES; yy_l++) {\n"
+        "            yy_lane *yy_p = &yy_lanes[yy_l];\n"
+        "            const char *yy_cp = yy_p->yy_cp;\n"
+        "            const char *yy_start;\n"
+        "            const char *yy_last;\n"
+        "            int yy_state = yy_p->yy_state;\n"
+        "            int yy_next = -1;\n"
+        "            int yy_rule;\n"
+        "            int yy_c;\n"
+        "\n"
+        "            (void)yy_c;\n"
+        "            if (yy_p->yy_stream < 0)\n"
+        "                continue;\n"
+        "            if (yy_cp < yy_p->yy_end) {\n";
+    emitTransition(out, 4);
+    out << "                if (yy_next < 0 && *yy_cp == '\\0')\n"
+        "                    yy_next = yy_nul_trans[yy_state];\n"
+        "            }\n"
+        "            if (yy_next >= 0) {\n"
+        "                yy_p->yy_state = yy_next;\n"
+        "                yy_p->yy_cp = yy_cp + 1;\n"
+        "                if (yy_accept[yy_next] >= 0) {\n"
+        "                    yy_p->yy_rule = yy_accept[yy_next];\n"
+        "                    yy_p->yy_last = yy_cp + 1;\n"
+        "                }\n"
+        "                continue;\n"
+        "            }\n"
+        "            /* the lane jammed or hit the end of its stream: the token is complete */\n"
+        "            yy_start = yy_p->yy_start;\n"
+        "            yy_last = yy_p->yy_last;\n"
+        "            yy_rule = yy_p->yy_rule;\n"
+        "            if (yy_last == yy_start) {\n"
+        "                yy_rule = -1;\n"
+        "                yy_last = yy_start + 1;\n"
+        "            }\n";
+    emitKeywordCheck(out, 3);
+    out << "            yy_emit(yy_p->yy_stream, yy_rule, yy_start, (size_t)(yy_last - yy_start), yy_arg);\n"
+        "            if (yy_last < yy_p->yy_end)\n"
+        "                yy_lane_begin(yy_p, yy_last);\n"
+        "            else if (!yy_lane_load(yy_p, yy_data, yy_sizes, yy_count, &yy_queued))\n"
+        "                yy_active--;\n"
+        "        }\n"
+        "    }\n"
+        "}\n"
+        "\n"
+        "#endif\n"
+        "\n";
+}
+
+/*
+One case per rule, labelled with its priority (the number the accept table
+holds). Unmatched bytes fall through to the default ECHO.
+*/
+void CodeGenerator::emitActions(std::ostream& out) const {
+    out << "        switch (yy_rule) {\n";
+    for (size_t i = 0; i < rules.size(); i++) {
+        out << "        case " << rules[i].priority << ":\n";
+        if (!rules[i].action.empty())
+            out << "            " << rules[i].action << "\n";
+        out << "            break;\n";
+    }
+    out << "        default:\n"
+        "            ECHO;\n"
+        "            break;\n"
+        "        }\n";
+}
+
+void CodeGenerator::emitEpilogue(std::ostream& out) const {
+    out << userCode << (userCode.empty() || userCode.back() == '\n' ? "" : "\n");
+    if (headerCode.find("yywrap") == std::string::npos && userCode.find("yywrap") == std::string::npos)
+        out << "\nint yywrap(void)\n{\n    return 1;\n}\n";
+}
+
+void CodeGenerator::generate(std::ostream& out) const {
+    emitPrologue(out);
+    emitTables(out);
+    emitKeywords(out);
+    emitInput(out);
+    emitSkipKernels(out);
+    emitScanner(out);
+    emitParallel(out);
+    emitBatch(out);
+    emitEpilogue(out);
+}
@@ -0,0 +1,162 @@
+#include "../../inc/codegen/KeywordTable.hpp"
+#include "../../inc/dfa/LazyDFA.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+KeywordTable::KeywordTable() : keywords(), hosts(), remaining(), displacements(), slots() {}
+
+/*
+A keyword is a literal rule of at least MIN_LENGTH bytes whose text the
+non-literal rules match in full; those rules' best match on it becomes a
+host. The coverage test runs the text through a lazy DFA of the
+non-literal rules.
+*/
+KeywordTable::KeywordTable(const std::vector<Rule>& rules)
+    :   keywords(), hosts(), remaining(), displacements(), slots() {
+    std::vector<Rule> general;
+    std::vector<std::string> texts(rules.size());
+    std::vector<bool> literal(rules.size(), false);
+    std::vector<bool> moved(rules.size(), false);
+    std::unordered_set<std::string> seen;
+
+    for (size_t i = 0; i < rules.size(); i++) {
+        literal[i] = literalString(rules[i].pattern, texts[i]) && texts[i].size() >= MIN_LENGTH;
+        if (!literal[i]) {
+            texts[i].clear();
+            general.push_back(rules[i]);
+        }
+    }
+
+    if (!general.empty()) {
+        NFA nfa = NFA::combineRules(general);
+        LazyDFA lazy(nfa, 1 << 20);
+
+        for (size_t i = 0; i < rules.size(); i++) {
+            int rule;
+            if (!literal[i] || lazy.longestMatch(texts[i].data(), texts[i].size(), rule) != texts[i].size())
+                continue ;
+            moved[i] = true;
+            // a repeated keyword can never match; the first one keeps the slot
+            if (!seen.insert(texts[i]).second)
+                continue ;
+            keywords.push_back({ texts[i], rules[i].priority });
+            if (std::find(hosts.begin(), hosts.end(), rule) == hosts.end())
+                hosts.push_back(rule);
+        }
+    }
+
+    for (size_t i = 0; i < rules.size(); i++) {
+        if (!moved[i])
+            remaining.push_back(rules[i]);
+    }
+    std::sort(hosts.begin(), hosts.end());
+    if (!keywords.empty())
+        buildHash();
+}
+
+bool KeywordTable::literalString(const RegexNode *node, std::string& text) {
+    if (const LiteralNode *literal = dynamic_cast<const LiteralNode *>(node)) {
+        text += literal->getChar();
+        return true;
+    }
+    if (const ConcatNode *concat = dynamic_cast<const ConcatNode *>(node))
+        return literalString(concat->getLeft(), text) && literalString(concat->getRight(), text);
+    return false;
+}
+
+/*
+FNV-1a over the text, started from the seed and the length. The generated
+scanner computes the same function.
+*/
+uint32_t KeywordTable::hash(const std::string& text, uint32_t seed) {
+    uint32_t h = (2166136261u ^ seed) + (uint32_t)text.size();
+
+    for (unsigned char c : text) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+/*
+Buckets are placed largest first; each gets the first displacement that
+lands all of its keys on free slots. Both tables are powers of two, and
+the slot table grows if some bucket finds no displacement.
+*/
+void KeywordTable::buildHash() {
+    size_t slotCount = 1;
+    while (slotCount < keywords.size())
+        slotCount <<= 1;
+    size_t bucketCount = std::max<size_t>(1, slotCount / 4);
+
+    for (;;) {
+        std::vector<std::vector<int>> buckets(bucketCount);
+        for (size_t i = 0; i < keywords.size(); i++)
+            buckets[hash(keywords[i].text, 0) & (bucketCount - 1)].push_back(i);
+
+        std::vector<int> order(bucketCount);
+        for (size_t b = 0; b < bucketCount; b++)
+            order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        displacements.assign(bucketCount, 0);
+        slots.assign(slotCount, -1);
+        bool placed = true;
+        for (int b : order) {
+            if (buckets[b].empty())
+                break ;
+            uint32_t seed = 1;
+            for (; seed < MAX_SEED; seed++) {
+                std::vector<size_t> taken;
+                bool fits = true;
+                for (int key : buckets[b]) {
+                    size_t slot = hash(keywords[key].text, seed) & (slotCount - 1);
+                    if (slots[slot] != -1 || std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+                        fits = false;
+                        break ;
+                    }
+                    taken.push_back(slot);
+                }
+                if (!fits)
+                    continue ;
+                for (size_t k = 0; k < taken.size(); k++)
+                    slots[taken[k]] = buckets[b][k];
+                displacements[b] = seed;
+                break ;
+            }
+            if (seed == MAX_SEED) {
+                placed = false;
+                break ;
+            }
+        }
+        if (placed)
+            return ;
+        slotCount <<= 1;
+    }
+}
+
+bool KeywordTable::isEmpty() const {
+    return keywords.empty();
+}
+
+const std::vector<Keyword>& KeywordTable::getKeywords() const {
+    return keywords;
+}
+
+const std::vector<int>& KeywordTable::getHosts() const {
+    return hosts;
+}
+
+const std::vector<Rule>& KeywordTable::getRemainingRules() const {
+    return remaining;
+}
+
+const std::vector<int32_t>& KeywordTable::getDisplacements() const {
+    return displacements;
+}
+
+const std::vector<int32_t>& KeywordTable::getSlots() const {
+    return slots;
+}
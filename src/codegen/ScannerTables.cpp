@@ -0,0 +1,210 @@
+#include "../../inc/codegen/ScannerTables.hpp"
+#include <algorithm>
+
+/*
+The DFA's classes get one extra column, NUL_CLASS, used only by byte 0;
+it never has a transition, so the scanner's sentinel always jams and the
+real transitions on NUL are kept in nulTransitions.
+*/
+ScannerTables::ScannerTables(const DFA& dfa, TableMode mode)
+    :   mode(mode), width(dfa.getClassCount() + 1), stateCount(dfa.getStateCount()),
+        classOf(256), accept(dfa.getAcceptTable()), nulTransitions(dfa.getStateCount()),
+        base(), def(), next(), check() {
+    std::vector<int32_t> table((size_t)stateCount * width, -1);
+    int nulClass = width - 1;
+
+    for (int c = 0; c < 256; c++)
+        classOf[c] = dfa.getClasses().getClass((unsigned char)c);
+    classOf[0] = nulClass;
+
+    for (int s = 0; s < stateCount; s++) {
+        for (int c = 0; c < nulClass; c++)
+            table[s * width + c] = dfa.getNext(s, c);
+        nulTransitions[s] = dfa.getNext(s, dfa.getClasses().getClass(0));
+    }
+
+    if (mode == TABLES_FULL)
+        next = table;
+    else
+        buildComb(table, mode == TABLES_COMPACT);
+}
+
+/*
+Picks each state's default among the previous DEFAULT_WINDOW states (the
+one whose row differs in the fewest classes, if that beats storing the row
+outright), then packs the stored entries first-fit, largest rows first.
+*/
+void ScannerTables::buildComb(const std::vector<int32_t>& table, bool defaults) {
+    std::vector<std::vector<int>> entries(stateCount);
+    std::vector<int> depth(stateCount, 0);
+
+    def.assign(stateCount, -1);
+    for (int s = 0; s < stateCount; s++) {
+        const int32_t *row = &table[s * width];
+        int best = -1;
+        int bestCost = 0;
+
+        for (int c = 0; c < width; c++) {
+            if (row[c] != -1)
+                bestCost++;
+        }
+
+        for (int d = std::max(0, s - DEFAULT_WINDOW); defaults && d < s; d++) {
+            if (depth[d] >= MAX_CHAIN)
+                continue ;
+            const int32_t *other = &table[d * width];
+            int cost = 0;
+            for (int c = 0; c < width && cost < bestCost; c++) {
+                if (row[c] != other[c])
+                    cost++;
+            }
+            if (cost < bestCost) {
+                best = d;
+                bestCost = cost;
+            }
+        }
+
+        def[s] = best;
+        depth[s] = (best == -1) ? 0 : depth[best] + 1;
+        for (int c = 0; c < width; c++) {
+            if (best == -1 ? row[c] != -1 : row[c] != table[best * width + c])
+                entries[s].push_back(c);
+        }
+    }
+
+    std::vector<int> order(stateCount);
+    for (int s = 0; s < stateCount; s++)
+        order[s] = s;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return entries[a].size() > entries[b].size();
+    });
+
+    base.assign(stateCount, 0);
+    size_t firstFree = 0;
+    int32_t maxBase = 0;
+    for (int s : order) {
+        if (entries[s].empty())
+            continue ;
+
+        while (firstFree < check.size() && check[firstFree] != -1)
+            firstFree++;
+
+        int32_t b = std::max(0, (int)firstFree - entries[s][0]);
+        for (;; b++) {
+            bool fits = true;
+            for (int c : entries[s]) {
+                size_t pos = b + c;
+                if (pos < check.size() && check[pos] != -1) {
+                    fits = false;
+                    break ;
+                }
+            }
+            if (fits)
+                break ;
+        }
+
+        base[s] = b;
+        maxBase = std::max(maxBase, b);
+        for (int c : entries[s]) {
+            size_t pos = b + c;
+            if (pos >= check.size()) {
+                check.resize(pos + 1, -1);
+                next.resize(pos + 1, -1);
+            }
+            check[pos] = s;
+            next[pos] = table[s * width + c];
+        }
+    }
+    // every base[s] + class lookup must stay inside the vectors
+    check.resize(std::max(check.size(), (size_t)maxBase + width), -1);
+    next.resize(check.size(), -1);
+
+    if (!defaults)
+        def.clear();
+}
+
+int32_t ScannerTables::lookup(int32_t state, int cls) const {
+    if (mode == TABLES_FULL)
+        return next[state * width + cls];
+
+    while (check[base[state] + cls] != state) {
+        if (def.empty() || def[state] == -1)
+            return -1;
+        state = def[state];
+    }
+    return next[base[state] + cls];
+}
+
+int ScannerTables::elementBytes(const std::vector<int32_t>& values) {
+    int bytes = 1;
+
+    for (int32_t value : values) {
+        if (value < -32768 || value > 32767)
+            return 4;
+        if (value < -128 || value > 127)
+            bytes = 2;
+    }
+    return bytes;
+}
+
+size_t ScannerTables::byteSize() const {
+    size_t size = 0;
+
+    size += classOf.size() * elementBytes(classOf);
+    size += accept.size() * elementBytes(accept);
+    size += nulTransitions.size() * elementBytes(nulTransitions);
+    size += base.size() * elementBytes(base);
+    size += def.size() * elementBytes(def);
+    size += next.size() * elementBytes(next);
+    size += check.size() * elementBytes(check);
+    return size;
+}
+
+TableMode ScannerTables::getMode() const {
+    return mode;
+}
+
+int ScannerTables::getWidth() const {
+    return width;
+}
+
+int ScannerTables::getStateCount() const {
+    return stateCount;
+}
+
+const std::vector<int32_t>& ScannerTables::getClassOf() const {
+    return classOf;
+}
+
+const std::vector<int32_t>& ScannerTables::getAccept() const {
+    return accept;
+}
+
+const std::vector<int32_t>& ScannerTables::getNulTransitions() const {
+    return nulTransitions;
+}
+
+const std::vector<int32_t>& ScannerTables::getBase() const {
+    return base;
+}
+
+const std::vector<int32_t>& ScannerTables::getDefault() const {
+    return def;
+}
+
+const std::vector<int32_t>& ScannerTables::getNext() const {
+    return next;
+}
+
+const std::vector<int32_t>& ScannerTables::getCheck() const {
+    return check;
+}
+
+const char *ScannerTables::modeName(TableMode mode) {
+    switch (mode) {
+        case TABLES_FULL: return "full";
+        case TABLES_COMB: return "comb";
+        case TABLES_COMPACT: return "compact";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,118 @@
+#include "../../inc/dfa/BackupAnalysis.hpp"
+#include "../../inc/utils/StringUtils.hpp"
+#include <algorithm>
+
+BackupAnalysis::BackupAnalysis(const DFA& dfa) : dfa(dfa), states() {
+    bool startReentered = false;
+
+    for (int s = 0; s < dfa.getStateCount() && !startReentered; s++) {
+        for (int c = 0; c < dfa.getClassCount(); c++) {
+            if (dfa.getNext(s, c) == dfa.getStart()) {
+                startReentered = true;
+                break ;
+            }
+        }
+    }
+
+    for (int s = 0; s < dfa.getStateCount(); s++) {
+        if (dfa.getAccept(s) >= 0)
+            continue ;
+        if (s == dfa.getStart() && !startReentered)
+            continue ;
+        states.push_back(s);
+    }
+}
+
+bool BackupAnalysis::hasBackingUp() const {
+    return !states.empty();
+}
+
+const std::vector<int>& BackupAnalysis::getStates() const {
+    return states;
+}
+
+/*
+The rules some accepting state reachable from state still wins: the
+rules a token passing through state may end up matching.
+*/
+std::vector<int> BackupAnalysis::liveRules(int state) const {
+    std::vector<bool> seen(dfa.getStateCount(), false);
+    std::vector<int> stack(1, state);
+    std::vector<int> rules;
+
+    seen[state] = true;
+    while (!stack.empty()) {
+        int current = stack.back();
+        stack.pop_back();
+        if (dfa.getAccept(current) >= 0)
+            rules.push_back(dfa.getAccept(current));
+        for (int c = 0; c < dfa.getClassCount(); c++) {
+            int target = dfa.getNext(current, c);
+            if (target >= 0 && !seen[target]) {
+                seen[target] = true;
+                stack.push_back(target);
+            }
+        }
+    }
+    std::sort(rules.begin(), rules.end());
+    rules.erase(std::unique(rules.begin(), rules.end()), rules.end());
+    return rules;
+}
+
+/*
+Prints a byte set as a bracket expression of ranges, e.g. [ 0-9a-z ].
+*/
+void BackupAnalysis::writeBytes(std::ostream& out, const std::vector<bool>& bytes) const {
+    out << "[ ";
+    for (int c = 0; c < 256; c++) {
+        if (!bytes[c])
+            continue ;
+        int last = c;
+        while (last + 1 < 256 && bytes[last + 1])
+            last++;
+        out << escape(std::string(1, (char)c));
+        if (last > c)
+            out << "-" << escape(std::string(1, (char)last));
+        c = last;
+    }
+    out << " ]";
+}
+
+/*
+Writes the report in the layout of flex's lex.backup: for each state, the
+rules (as file:line) a token in it may be heading for, and the bytes it
+can and cannot continue on.
+*/
+void BackupAnalysis::writeReport(std::ostream& out, const std::vector<Rule>& rules,
+    const std::string& file) const {
+    if (states.empty()) {
+        out << "No backing up.\n";
+        return ;
+    }
+
+    for (int state : states) {
+        std::vector<bool> outBytes(256, false);
+        std::vector<bool> jamBytes(256, false);
+
+        for (int c = 0; c < 256; c++) {
+            int target = dfa.getNext(state, dfa.getClasses().getClass((unsigned char)c));
+            outBytes[c] = target >= 0;
+            jamBytes[c] = target < 0;
+        }
+
+        out << "State #" << state << " is non-accepting -\n"
+            << " associated rules:\n";
+        for (int rule : liveRules(state)) {
+            for (const Rule& r : rules) {
+                if (r.priority == rule)
+                    out << "\t" << file << ":" << r.line << "\n";
+            }
+        }
+        out << " out-transitions: ";
+        writeBytes(out, outBytes);
+        out << "\n jam-transitions: EOF ";
+        writeBytes(out, jamBytes);
+        out << "\n\n";
+    }
+    out << states.size() << " non-accepting states may back up.\n";
+}
@@ -1,97 +1,554 @@
 #include "../../inc/dfa/DFA.hpp"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
 
-DFAState::DFAState(int id, const std::set<NFAState*>& nfaStates)
-    :   id(id), accepting(false), ruleNumber(-1), nfaStates(nfaStates) {
+StateSetTable::StateSetTable() : pool(), offsets(1, 0), hashes(), buckets(64, -1) {}
 
-    for (NFAState *state :  nfaStates) {
-        if (state->accepting) {
-            accepting = true;
-            if (ruleNumber == -1 || state->ruleNumber < ruleNumber)
-                ruleNumber = state->ruleNumber;
+bool StateSetTable::equals(int id, const StateSet& set) const {
+    if (offsets[id + 1] - offsets[id] != set.size())
+        return false;
+    return std::equal(set.begin(), set.end(), pool.begin() + offsets[id]);
+}
+
+void StateSetTable::grow() {
+    buckets.assign(buckets.size() * 2, -1);
+    size_t mask = buckets.size() - 1;
+
+    for (size_t id = 0; id < hashes.size(); id++) {
+        size_t slot = hashes[id] & mask;
+        while (buckets[slot] != -1)
+            slot = (slot + 1) & mask;
+        buckets[slot] = id;
+    }
+}
+
+int StateSetTable::find(const StateSet& set) const {
+    size_t hash = StateSetHash()(set);
+    size_t mask = buckets.size() - 1;
+
+    for (size_t slot = hash & mask; buckets[slot] != -1; slot = (slot + 1) & mask) {
+        int id = buckets[slot];
+        if (hashes[id] == hash && equals(id, set))
+            return id;
+    }
+    return -1;
+}
+
+int StateSetTable::intern(const StateSet& set, bool& inserted) {
+    size_t hash = StateSetHash()(set);
+    size_t mask = buckets.size() - 1;
+    size_t slot = hash & mask;
+
+    while (buckets[slot] != -1) {
+        int id = buckets[slot];
+        if (hashes[id] == hash && equals(id, set)) {
+            inserted = false;
+            return id;
         }
+        slot = (slot + 1) & mask;
     }
+
+    int id = hashes.size();
+    pool.insert(pool.end(), set.begin(), set.end());
+    offsets.push_back(pool.size());
+    hashes.push_back(hash);
+    buckets[slot] = id;
+    if (hashes.size() * 2 > buckets.size())
+        grow();
+    inserted = true;
+    return id;
+}
+
+size_t StateSetTable::size() const {
+    return hashes.size();
+}
+
+const int *StateSetTable::begin(int id) const {
+    return pool.data() + offsets[id];
+}
+
+const int *StateSetTable::end(int id) const {
+    return pool.data() + offsets[id + 1];
+}
+
+void StateSetTable::clear() {
+    pool.clear();
+    offsets.assign(1, 0);
+    hashes.clear();
+    buckets.assign(64, -1);
+}
+
+DFA::DFA(const ByteClasses& classes, int stateCount,
+    const std::vector<int32_t>& next, const std::vector<int32_t>& accept)
+    : classes(classes), stateCount(stateCount), next(next), accept(accept) {}
+
+int DFA::getStart() const {
+    return 0;
+}
+
+int DFA::getStateCount() const {
+    return stateCount;
+}
+
+int DFA::getClassCount() const {
+    return classes.getCount();
+}
+
+const ByteClasses& DFA::getClasses() const {
+    return classes;
 }
 
-DFA::DFA(DFAState* start, const std::set<DFAState*>& states)
-    : start(start), states(states) {}
+int32_t DFA::getNext(int state, int cls) const {
+    return next[state * classes.getCount() + cls];
+}
 
-DFA::~DFA() {
-    for (DFAState* state : states)
-        delete state;
+int32_t DFA::getAccept(int state) const {
+    return accept[state];
 }
 
-DFAState *DFA::getStart() const {
-    return start;
+const std::vector<int32_t>& DFA::getNextTable() const {
+    return next;
 }
 
-std::set<DFAState*> DFA::getStates() const {
-    return states;
+const std::vector<int32_t>& DFA::getAcceptTable() const {
+    return accept;
 }
 
-std::set<NFAState*> DFA::epsilonClosure(const std::set<NFAState*>& states) {
-    std::set<NFAState*> result;
-    std::queue<NFAState*> worklist;
+size_t DFA::longestMatch(const char *input, size_t length, int& rule) const {
+    const int *classOf = classes.getMap();
+    const int32_t *table = next.data();
+    int width = classes.getCount();
+    int32_t state = 0;
+    size_t matched = 0;
 
-    for (NFAState* state : states) {
-        result.insert(state);
-        worklist.push(state);
+    rule = accept[0];
+    for (size_t i = 0; i < length; i++) {
+        state = table[state * width + classOf[(unsigned char)input[i]]];
+        if (state < 0)
+            break ;
+        if (accept[state] != -1) {
+            rule = accept[state];
+            matched = i + 1;
+        }
     }
+    return matched;
+}
 
-    while (!worklist.empty()) {
-        NFAState* current = worklist.front();
-        worklist.pop();
+StateSet DFA::epsilonClosure(const NFA& nfa, const StateSet& states) {
+    StateMarks marks(nfa.getStateCount());
+    return epsilonClosure(nfa, states, marks);
+}
 
-        for (NFAState *next : current->epsilonTransitions) {
-            if (result.find(next) == result.end()) {
-                result.insert(next);
-                worklist.push(next);
-            }
+StateSet DFA::epsilonClosure(const NFA& nfa, const StateSet& states, StateMarks& marks) {
+    StateSet result;
+
+    marks.clear();
+    for (int id : states) {
+        for (int reached : nfa.getClosure(id)) {
+            if (marks.insert(reached))
+                result.push_back(reached);
         }
-    }   
+    }
 
+    std::sort(result.begin(), result.end());
     return result;
 }
 
-DFA DFA::fromNFA(const NFA& nfa) {
-    std::set<DFAState*> dfaStates;
-    std::queue<DFAState*> worklist;
-    std::map<std::set<NFAState*>, DFAState*> stateMap;
-    int id = 0;
+static int32_t acceptingRule(const NFA& nfa, const int *begin, const int *end) {
+    int32_t rule = -1;
 
-    std::set<NFAState*> startStates = epsilonClosure({nfa.getStart()}); 
-    DFAState *start = new DFAState(id++, startStates);
-    worklist.push(start);
-    dfaStates.insert(start);
-    stateMap[startStates] = start;
+    for (const int *id = begin; id != end; id++) {
+        const NFAState& state = nfa.getState(*id);
+        if (state.accepting && (rule == -1 || state.ruleNumber < rule))
+            rule = state.ruleNumber;
+    }
+    return rule;
+}
 
-    while (!worklist.empty()) {
-        DFAState *current = worklist.front();
-        worklist.pop();
-
-        for (int c = 0; c < 256; c++) {
-            std::set<NFAState *> reachable;
-            for (NFAState * nfaState : current->nfaStates) {
-                auto it = nfaState->transitions.find((char)c);
-                if (it != nfaState->transitions.end())
-                    reachable.insert(it->second.begin(), it->second.end());
+/*
+Replaces moves[cls], the NFA states reached on each byte class, with its
+epsilon-closure: the successor of the DFA state on that class.
+*/
+static void expandState(const NFA& nfa, const int *begin, const int *end,
+    std::vector<StateSet>& moves, StateMarks& marks) {
+    for (const int *id = begin; id != end; id++) {
+        const NFAState& state = nfa.getState(*id);
+        const int *cls = nfa.getTransitionClasses(*id);
+        for (int i = state.classBegin; i < state.classEnd; i++)
+            moves[*cls++].push_back(state.out);
+    }
+
+    for (size_t cls = 0; cls < moves.size(); cls++) {
+        if (!moves[cls].empty())
+            moves[cls] = DFA::epsilonClosure(nfa, moves[cls], marks);
+    }
+}
+
+DFA DFA::fromNFA(const NFA& nfa, int threads) {
+    if (threads > 1)
+        return fromNFAParallel(nfa, threads);
+
+    const ByteClasses& classes = nfa.getClasses();
+    int width = classes.getCount();
+    StateSetTable dfaStates;
+    std::vector<StateSet> moves(width);
+    StateMarks marks(nfa.getStateCount());
+    std::vector<int32_t> next;
+    std::vector<int32_t> accept;
+    bool inserted;
+
+    dfaStates.intern(epsilonClosure(nfa, StateSet(1, nfa.getStart()), marks), inserted);
+
+    for (size_t current = 0; current < dfaStates.size(); current++) {
+        next.resize((current + 1) * width, -1);
+        accept.push_back(acceptingRule(nfa, dfaStates.begin(current), dfaStates.end(current)));
+        expandState(nfa, dfaStates.begin(current), dfaStates.end(current), moves, marks);
+
+        for (int cls = 0; cls < width; cls++) {
+            if (moves[cls].empty())
+                continue ;
+            next[current * width + cls] = dfaStates.intern(moves[cls], inserted);
+            moves[cls].clear();
+        }
+    }
+    return DFA(classes, dfaStates.size(), next, accept);
+}
+
+/*
+State sets shared by the construction threads. A set's hash picks a shard,
+and each shard is a StateSetTable behind its own mutex. The ids handed out
+are shard-local; canonical DFA ids are assigned later, by one thread.
+*/
+struct SharedStateSets {
+    static const int SHARDS = 64;
+
+    StateSetTable tables[SHARDS];
+    std::mutex locks[SHARDS];
+    std::vector<int> canonical[SHARDS];
+
+    std::pair<int, int> intern(const StateSet& set) {
+        int shard = (StateSetHash()(set) >> 32) % SHARDS;
+        std::lock_guard<std::mutex> guard(locks[shard]);
+        bool inserted;
+        int local = tables[shard].intern(set, inserted);
+
+        if (inserted)
+            canonical[shard].push_back(-1);
+        return std::make_pair(shard, local);
+    }
+};
+
+/*
+Level-synchronous subset construction. Worker threads take the states of
+the current breadth-first level from a shared cursor, compute their
+successors and intern them in the sharded table. Between levels, one
+thread walks the level in state order and class order and numbers the new
+states, which is the order sequential construction discovers them in, so
+the result is identical for any thread count.
+*/
+DFA DFA::fromNFAParallel(const NFA& nfa, int threads) {
+    const ByteClasses& classes = nfa.getClasses();
+    int width = classes.getCount();
+    SharedStateSets sets;
+    std::vector<std::vector<StateSet>> moves(threads, std::vector<StateSet>(width));
+    std::vector<StateMarks> marks(threads, StateMarks(nfa.getStateCount()));
+    std::vector<StateSet> frontier;
+    std::vector<int32_t> next;
+    std::vector<int32_t> accept;
+    int count = 1;
+
+    frontier.push_back(epsilonClosure(nfa, StateSet(1, nfa.getStart()), marks[0]));
+    std::pair<int, int> start = sets.intern(frontier[0]);
+    sets.canonical[start.first][start.second] = 0;
+
+    while (!frontier.empty()) {
+        std::vector<std::pair<int, int>> found(frontier.size() * width, std::make_pair(-1, -1));
+        std::atomic<size_t> cursor(0);
+
+        auto work = [&](int worker) {
+            size_t i;
+            while ((i = cursor++) < frontier.size()) {
+                const int *begin = frontier[i].data();
+                expandState(nfa, begin, begin + frontier[i].size(), moves[worker], marks[worker]);
+                for (int cls = 0; cls < width; cls++) {
+                    if (moves[worker][cls].empty())
+                        continue ;
+                    found[i * width + cls] = sets.intern(moves[worker][cls]);
+                    moves[worker][cls].clear();
+                }
             }
+        };
+
+        // small levels are not worth a thread start
+        int workers = std::min((size_t)threads, (frontier.size() + 31) / 32);
+        std::vector<std::thread> pool;
+        for (int t = 1; t < workers; t++)
+            pool.push_back(std::thread(work, t));
+        work(0);
+        for (std::thread& thread : pool)
+            thread.join();
+
+        std::vector<StateSet> level;
+        for (size_t i = 0; i < frontier.size(); i++) {
+            const int *begin = frontier[i].data();
+            accept.push_back(acceptingRule(nfa, begin, begin + frontier[i].size()));
+            for (int cls = 0; cls < width; cls++) {
+                std::pair<int, int> loc = found[i * width + cls];
+                if (loc.first == -1) {
+                    next.push_back(-1);
+                    continue ;
+                }
+                int& id = sets.canonical[loc.first][loc.second];
+                if (id == -1) {
+                    id = count++;
+                    const StateSetTable& table = sets.tables[loc.first];
+                    level.push_back(StateSet(table.begin(loc.second), table.end(loc.second)));
+                }
+                next.push_back(id);
+            }
+        }
+        frontier.swap(level);
+    }
+    return DFA(classes, count, next, accept);
+}
+
+/*
+Direct construction from the rule ASTs (Aho, Sethi, Ullman): each DFA
+state is a set of positions and its successors come from followpos, so no
+epsilon-NFA or closure is involved. Each rule is augmented with an
+end-marker position that makes a state accept that rule.
+*/
+DFA DFA::fromRules(const std::vector<Rule>& rules) {
+    ByteClasses classes;
+    PositionTable table;
+    StateSet start;
+
+    for (const Rule& rule : rules)
+        rule.pattern->collectByteClasses(classes);
+
+    for (const Rule& rule : rules) {
+        PositionInfo info = rule.pattern->computePositions(table);
+        StateSet marker(1, table.addEndMarker(rule.priority));
+
+        table.addFollow(info.lastpos, marker);
+        start.insert(start.end(), info.firstpos.begin(), info.firstpos.end());
+        if (info.nullable)
+            start.push_back(marker[0]);
+    }
+    std::sort(start.begin(), start.end());
+    start.erase(std::unique(start.begin(), start.end()), start.end());
+    table.finish(classes);
 
-            if (reachable.empty())
+    int width = classes.getCount();
+    StateSetTable dfaStates;
+    std::vector<StateSet> moves(width);
+    StateMarks marks(table.size());
+    std::vector<int32_t> next;
+    std::vector<int32_t> accept;
+    bool inserted;
+
+    dfaStates.intern(start, inserted);
+
+    for (size_t current = 0; current < dfaStates.size(); current++) {
+        int32_t rule = -1;
+
+        next.resize((current + 1) * width, -1);
+        for (const int *pos = dfaStates.begin(current); pos != dfaStates.end(current); pos++) {
+            int marker = table.getRule(*pos);
+            if (marker != -1 && (rule == -1 || marker < rule))
+                rule = marker;
+            for (int cls : table.getClasses(*pos))
+                moves[cls].push_back(*pos);
+        }
+        accept.push_back(rule);
+
+        for (int cls = 0; cls < width; cls++) {
+            if (moves[cls].empty())
+                continue ;
+
+            StateSet target;
+            marks.clear();
+            for (int pos : moves[cls]) {
+                for (int follow : table.getFollow(pos)) {
+                    if (marks.insert(follow))
+                        target.push_back(follow);
+                }
+            }
+            moves[cls].clear();
+            if (target.empty())
                 continue ;
+            std::sort(target.begin(), target.end());
+            next[current * width + cls] = dfaStates.intern(target, inserted);
+        }
+    }
+    return DFA(classes, dfaStates.size(), next, accept);
+}
+
+/*
+Hopcroft partition refinement. Missing transitions go to an implicit dead
+state (id n) so the automaton is complete; the block that ends up holding
+it is dropped from the result. Accepting states start in one block per
+rule number, so states accepting different rules are never merged.
+
+The partition is one array of states with each block a contiguous range
+of it. A splitter's predecessors are swapped to the front of their block,
+so splitting a block costs only the states that move.
+*/
+DFA DFA::minimize() const {
+    int n = stateCount;
+    int dead = n;
+    int width = classes.getCount();
+
+    // inverse transitions, grouped by target state and class
+    std::vector<int> predStart((size_t)(n + 1) * width + 1, 0);
+    std::vector<int> preds((size_t)(n + 1) * width);
+    for (int s = 0; s <= n; s++) {
+        for (int c = 0; c < width; c++) {
+            int target = s == dead ? dead : next[s * width + c];
+            predStart[(size_t)(target == -1 ? dead : target) * width + c + 1]++;
+        }
+    }
+    for (size_t i = 1; i < predStart.size(); i++)
+        predStart[i] += predStart[i - 1];
+    std::vector<int> fill(predStart.begin(), predStart.end() - 1);
+    for (int s = 0; s <= n; s++) {
+        for (int c = 0; c < width; c++) {
+            int target = s == dead ? dead : next[s * width + c];
+            preds[fill[(size_t)(target == -1 ? dead : target) * width + c]++] = s;
+        }
+    }
 
-            std::set<NFAState *> closure = epsilonClosure(reachable);
-            DFAState *next;
+    std::vector<int> blockOf(n + 1);
+    std::vector<int> blockBegin;
+    std::vector<int> blockEnd;
+    std::map<int, int> blockByRule;
+    for (int s = 0; s <= n; s++) {
+        int rule = (s == dead) ? -1 : accept[s];
+        if (blockByRule.find(rule) == blockByRule.end()) {
+            blockByRule[rule] = blockBegin.size();
+            blockBegin.push_back(0);
+            blockEnd.push_back(0);
+        }
+        blockOf[s] = blockByRule[rule];
+        blockEnd[blockOf[s]]++;
+    }
+    for (size_t b = 1; b < blockBegin.size(); b++) {
+        blockBegin[b] = blockEnd[b - 1];
+        blockEnd[b] += blockBegin[b];
+    }
+    std::vector<int> elements(n + 1);
+    std::vector<int> location(n + 1);
+    std::vector<int> placed(blockBegin);
+    for (int s = 0; s <= n; s++) {
+        location[s] = placed[blockOf[s]]++;
+        elements[location[s]] = s;
+    }
+
+    std::vector<int> worklist;
+    std::vector<bool> inWorklist(blockBegin.size(), false);
+    size_t largest = 0;
+    for (size_t b = 1; b < blockBegin.size(); b++) {
+        if (blockEnd[b] - blockBegin[b] > blockEnd[largest] - blockBegin[largest])
+            largest = b;
+    }
+    for (size_t b = 0; b < blockBegin.size(); b++) {
+        if (b != largest) {
+            worklist.push_back(b);
+            inWorklist[b] = true;
+        }
+    }
+
+    std::vector<int> marked(blockBegin.size(), 0);
+    std::vector<int> splitter;
+    std::vector<int> touched;
+
+    while (!worklist.empty()) {
+        int block = worklist.back();
+        worklist.pop_back();
+        inWorklist[block] = false;
+        // the block may itself split while its classes are processed
+        splitter.assign(elements.begin() + blockBegin[block], elements.begin() + blockEnd[block]);
 
-            if (stateMap.find(closure) == stateMap.end()) {
-                next = new DFAState(id++, closure);
-                stateMap[closure] = next;
-                dfaStates.insert(next);
-                worklist.push(next);
-            } else {
-                next = stateMap[closure];
+        for (int c = 0; c < width; c++) {
+            touched.clear();
+            for (int t : splitter) {
+                size_t at = (size_t)t * width + c;
+                for (int i = predStart[at]; i < predStart[at + 1]; i++) {
+                    int s = preds[i];
+                    int b = blockOf[s];
+                    int front = blockBegin[b] + marked[b];
+
+                    if (location[s] < front)
+                        continue ;
+                    if (marked[b]++ == 0)
+                        touched.push_back(b);
+                    int other = elements[front];
+                    elements[front] = s;
+                    elements[location[s]] = other;
+                    location[other] = location[s];
+                    location[s] = front;
+                }
+            }
+
+            for (int b : touched) {
+                int split = blockBegin[b] + marked[b];
+                marked[b] = 0;
+                if (split == blockEnd[b])
+                    continue ;
+                int nb = blockBegin.size();
+                blockBegin.push_back(blockBegin[b]);
+                blockEnd.push_back(split);
+                blockBegin[b] = split;
+                for (int i = blockBegin[nb]; i < split; i++)
+                    blockOf[elements[i]] = nb;
+                inWorklist.push_back(false);
+                marked.push_back(0);
+
+                if (inWorklist[b] || blockEnd[nb] - blockBegin[nb] <= blockEnd[b] - blockBegin[b]) {
+                    worklist.push_back(nb);
+                    inWorklist[nb] = true;
+                } else {
+                    worklist.push_back(b);
+                    inWorklist[b] = true;
+                }
             }
-            current->transitions[(char)c] = next;
         }
     }
-    return DFA(start, dfaStates);
-}
\ No newline at end of file
+
+    int deadBlock = blockOf[dead];
+    std::vector<int> newId(blockBegin.size(), -1);
+    std::vector<int> representative;
+
+    newId[blockOf[0]] = 0;
+    representative.push_back(0);
+    for (size_t i = 0; i < representative.size(); i++) {
+        int rep = representative[i];
+        for (int c = 0; c < width; c++) {
+            int target = next[rep * width + c];
+            if (target == -1)
+                continue ;
+            int tb = blockOf[target];
+            if (tb == deadBlock || newId[tb] != -1)
+                continue ;
+            newId[tb] = representative.size();
+            representative.push_back(target);
+        }
+    }
+
+    int count = representative.size();
+    std::vector<int32_t> minimalNext(count * width, -1);
+    std::vector<int32_t> minimalAccept(count);
+    for (int i = 0; i < count; i++) {
+        int rep = representative[i];
+        minimalAccept[i] = accept[rep];
+        for (int c = 0; c < width; c++) {
+            int target = next[rep * width + c];
+            if (target != -1 && blockOf[target] != deadBlock)
+                minimalNext[i * width + c] = newId[blockOf[target]];
+        }
+    }
+    return DFA(classes, count, minimalNext, minimalAccept);
+}
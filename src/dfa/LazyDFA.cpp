@@ -0,0 +1,99 @@
+#include "../../inc/dfa/LazyDFA.hpp"
+
+const int32_t LazyDFA::UNKNOWN;
+
+LazyDFA::LazyDFA(const NFA& nfa, size_t budget)
+    :   nfa(nfa), width(nfa.getClasses().getCount()), budget(budget), used(0), flushes(0),
+        states(), next(), accept(), startSet(), start(-1), marks(nfa.getStateCount()) {
+    startSet = DFA::epsilonClosure(nfa, StateSet(1, nfa.getStart()), marks);
+}
+
+int32_t LazyDFA::addState(const StateSet& set) {
+    bool inserted;
+    int32_t id = states.intern(set, inserted);
+    int32_t rule = -1;
+
+    for (int nfaId : set) {
+        const NFAState& state = nfa.getState(nfaId);
+        if (state.accepting && (rule == -1 || state.ruleNumber < rule))
+            rule = state.ruleNumber;
+    }
+    next.resize(next.size() + width, UNKNOWN);
+    accept.push_back(rule);
+    used += (width + 1 + set.size()) * sizeof(int32_t);
+    return id;
+}
+
+void LazyDFA::flush() {
+    states.clear();
+    next.clear();
+    accept.clear();
+    used = 0;
+    start = -1;
+    flushes++;
+}
+
+/*
+Builds the transition of state on cls. If the target is new and the cache
+is full, everything is flushed first; the old state id is then stale, so
+the transition is not recorded and only the target id is returned.
+*/
+int32_t LazyDFA::computeNext(int32_t state, int cls) {
+    unsigned char c = nfa.getClasses().representative(cls);
+    StateSet moves;
+
+    for (const int *id = states.begin(state); id != states.end(state); id++) {
+        const NFAState& nfaState = nfa.getState(*id);
+        if (nfaState.out != -1 && nfaState.chars.test(c))
+            moves.push_back(nfaState.out);
+    }
+
+    int32_t target = -1;
+    if (!moves.empty()) {
+        StateSet closure = DFA::epsilonClosure(nfa, moves, marks);
+        target = states.find(closure);
+        if (target == -1) {
+            if (used + (width + 1 + closure.size()) * sizeof(int32_t) > budget) {
+                flush();
+                return addState(closure);
+            }
+            target = addState(closure);
+        }
+    }
+    next[state * width + cls] = target;
+    return target;
+}
+
+size_t LazyDFA::longestMatch(const char *input, size_t length, int& rule) {
+    const int *classOf = nfa.getClasses().getMap();
+    size_t matched = 0;
+
+    if (start == -1)
+        start = addState(startSet);
+
+    int32_t state = start;
+    rule = accept[state];
+    for (size_t i = 0; i < length; i++) {
+        int cls = classOf[(unsigned char)input[i]];
+        int32_t target = next[state * width + cls];
+
+        if (target == UNKNOWN)
+            target = computeNext(state, cls);
+        if (target < 0)
+            break ;
+        state = target;
+        if (accept[state] != -1) {
+            rule = accept[state];
+            matched = i + 1;
+        }
+    }
+    return matched;
+}
+
+size_t LazyDFA::getCachedStates() const {
+    return states.size();
+}
+
+size_t LazyDFA::getFlushes() const {
+    return flushes;
+}
@@ -1,8 +1,15 @@
 #include "../inc/tokenizer/Tokenizer.hpp"
 #include "../inc/parser/Parser.hpp"
+#include "../inc/regex/RegexPool.hpp"
+#include "../inc/dfa/DFA.hpp"
+#include "../inc/dfa/LazyDFA.hpp"
+#include "../inc/dfa/BackupAnalysis.hpp"
+#include "../inc/codegen/CodeGenerator.hpp"
 #include "../inc/utils/FileUtils.hpp"
 #include "../inc/utils/Logger.hpp"
+#include "../inc/utils/Options.hpp"
 #include <iostream>
+#include <fstream>
 
 void printTokens(const std::vector<Token>& tokens) {
     std::cout << "\n=== TOKENS ===\n";
@@ -31,6 +38,10 @@ void printAST(RegexNode* node, int depth = 0) {
     } else if (QuestionNode* q = dynamic_cast<QuestionNode*>(node)) {
         std::cout << indent << "Question\n";
         printAST(q->getChild(), depth + 1);
+    } else if (RepeatNode* repeat = dynamic_cast<RepeatNode*>(node)) {
+        std::cout << indent << "Repeat{" << repeat->getMin() << ","
+                  << (repeat->getMax() == RepeatNode::UNBOUNDED ? "" : std::to_string(repeat->getMax())) << "}\n";
+        printAST(repeat->getChild(), depth + 1);
     } else if (ConcatNode* concat = dynamic_cast<ConcatNode*>(node)) {
         std::cout << indent << "Concat\n";
         printAST(concat->getLeft(), depth + 1);
@@ -52,31 +63,151 @@ void printRules(const std::vector<Rule>& rules) {
     }
 }
 
+/*
+Runs the rules over text in-process the way a generated scanner would:
+longest match, earliest rule on ties, unmatched bytes echoed. Prints one
+line per token.
+*/
+template <typename Engine>
+void scanText(Engine& engine, const std::string& text) {
+    size_t pos = 0;
+
+    while (pos < text.size()) {
+        int rule;
+        size_t length = engine.longestMatch(text.data() + pos, text.size() - pos, rule);
+
+        if (rule == -1 || length == 0) {
+            std::cout << "echo\t\"" << escape(text.substr(pos, 1)) << "\"\n";
+            pos++;
+            continue ;
+        }
+        std::cout << "rule " << rule << "\t\"" << escape(text.substr(pos, length)) << "\"\n";
+        pos += length;
+    }
+}
+
+/*
+Logs the size of every table layout for the minimized DFA and returns the
+selected one.
+*/
+ScannerTables buildTables(const DFA& dfa, const std::string& selected) {
+    static const TableMode modes[] = { TABLES_FULL, TABLES_COMB, TABLES_COMPACT };
+    std::string report = "Scanner tables:";
+    TableMode chosen = TABLES_FULL;
+
+    for (TableMode mode : modes) {
+        ScannerTables tables(dfa, mode);
+        bool isSelected = selected == ScannerTables::modeName(mode);
+
+        report += std::string(" ") + ScannerTables::modeName(mode) + " "
+            + std::to_string(tables.byteSize()) + " bytes" + (isSelected ? " (selected)" : "")
+            + (mode == TABLES_COMPACT ? "" : ",");
+        if (isSelected)
+            chosen = mode;
+    }
+    logInfo(report);
+    return ScannerTables(dfa, chosen);
+}
+
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        logError("Usage: ./ft_lex <file.l>");
+    Options options;
+
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception& e) {
+        logError(e.what());
         return 1;
     }
 
     try {
-        // Read input file
-        std::string input = readFile(argv[1]);
+        // Map the input file; tokens are slices of it, so it outlives the parse
+        MappedFile file(options.input);
+        std::string_view input = file.view();
         if (input.empty()) {
-            logError("Failed to read file: " + std::string(argv[1]));
+            logError("Failed to read file: " + options.input);
             return 1;
         }
 
-        // Tokenize
-        logInfo("Tokenizing...");
-        Tokenizer tokenizer(input);
-        std::vector<Token> tokens = tokenizer.tokenize();
-        printTokens(tokens);
-
-        // Parse
+        // Tokenize and parse; the parser pulls tokens as it goes
+        if (options.debug)
+            printTokens(Tokenizer(input).tokenize());
         logInfo("Parsing...");
-        Parser parser(tokens);
+        Tokenizer tokenizer(input);
+        Parser parser(tokenizer);
         std::vector<Rule> rules = parser.parse();
-        printRules(rules);
+        if (options.debug)
+            printRules(rules);
+
+        // Share equal subexpressions across rules; the pool owns the patterns from here
+        RegexPool pool;
+        for (Rule& rule : rules)
+            rule.pattern = pool.intern(rule.pattern);
+        logInfo("Regex DAG: " + std::to_string(pool.getTreeNodeCount()) + " tree nodes -> "
+            + std::to_string(pool.getNodeCount()) + " shared nodes");
+
+        if (options.lazy) {
+            NFA nfa = NFA::combineRules(rules);
+            LazyDFA lazy(nfa, options.lazyCache);
+            scanText(lazy, readFile(options.scan));
+            logInfo("Lazy DFA: " + std::to_string(lazy.getCachedStates()) + " states cached, "
+                + std::to_string(lazy.getFlushes()) + " cache flushes");
+            return 0;
+        }
+
+        // Keyword rules the generated scanner looks up in a hash instead
+        KeywordTable keywords = options.keywords && options.scan.empty() ? KeywordTable(rules) : KeywordTable();
+        const std::vector<Rule>& dfaRules = keywords.isEmpty() ? rules : keywords.getRemainingRules();
+        if (!keywords.isEmpty())
+            logInfo(std::to_string(keywords.getKeywords().size()) + " keywords moved to a hash table of "
+                + std::to_string(keywords.getSlots().size()) + " slots, "
+                + std::to_string(keywords.getHosts().size()) + " host rules");
+
+        // Build automata
+        logInfo(options.followpos ? "Building DFA from followpos..." : "Building DFA from NFA...");
+        DFA dfa = options.followpos ? DFA::fromRules(dfaRules) : DFA::fromNFA(NFA::combineRules(dfaRules), options.threads);
+        DFA minimal = dfa.minimize();
+        logInfo("DFA states: " + std::to_string(dfa.getStateCount())
+            + " -> " + std::to_string(minimal.getStateCount()) + " after minimization, "
+            + std::to_string(minimal.getClassCount()) + " byte classes");
+        if (!options.scan.empty()) {
+            scanText(minimal, readFile(options.scan));
+            return 0;
+        }
+
+        // Backing-up analysis
+        BackupAnalysis backup(minimal);
+        logInfo(backup.hasBackingUp()
+            ? std::to_string(backup.getStates().size()) + " DFA states may back up"
+            : "No backing up");
+        if (options.backupReport) {
+            std::ofstream report("lex.backup");
+            if (!report)
+                throw std::runtime_error("cannot write lex.backup");
+            backup.writeReport(report, rules, options.input);
+        }
+        if (options.noBackup && backup.hasBackingUp())
+            throw std::runtime_error(std::to_string(backup.getStates().size())
+                + " DFA states may back up" + (options.backupReport ? " (see lex.backup)" : " (run with -b for details)"));
+
+        // Generate the scanner
+        ScannerTables tables = buildTables(minimal, options.tables);
+        GeneratorOptions generatorOptions;
+        generatorOptions.direct = options.direct;
+        generatorOptions.mmap = options.mmap;
+        generatorOptions.backup = backup.hasBackingUp();
+        generatorOptions.simd = options.simd;
+        generatorOptions.parallel = options.parallel;
+        generatorOptions.batch = options.batch;
+        CodeGenerator generator(tables, rules, keywords, parser.getHeaderCode(), parser.getUserCode(), generatorOptions);
+        if (options.stdoutOutput)
+            generator.generate(std::cout);
+        else {
+            logInfo("Writing lex.yy.c...");
+            std::ofstream out("lex.yy.c");
+            if (!out)
+                throw std::runtime_error("cannot write lex.yy.c");
+            generator.generate(out);
+        }
 
         logInfo("Success!");
 
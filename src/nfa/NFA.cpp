@@ -1,56 +1,211 @@
 #include "../../inc/nfa/NFA.hpp"
+#include <algorithm>
 
-NFA::NFA(NFAState* start) : start(start) {
-    std::set<NFAState*> visited;
-    std::queue<NFAState*> queue;
-    queue.push(start);
+size_t StateSetHash::operator()(const StateSet& set) const {
+    size_t hash = 14695981039346656037ULL;
 
-    while (!queue.empty()) {
-        NFAState* current = queue.front();
-        queue.pop();
+    for (int id : set) {
+        hash ^= (size_t)id;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
 
-        if (visited.find(current) != visited.end())
-            continue ;
+StateMarks::StateMarks(size_t size) : marks(size, 0), stamp(0) {}
+
+void StateMarks::clear() {
+    if (++stamp == 0) {
+        std::fill(marks.begin(), marks.end(), 0);
+        stamp = 1;
+    }
+}
 
-        visited.insert(current);
-        states.insert(current);
+bool StateMarks::insert(int id) {
+    if (marks[id] == stamp)
+        return false;
+    marks[id] = stamp;
+    return true;
+}
 
-        for (auto& transition : current->transitions) {
-            for (NFAState* next : transition.second)
-                queue.push(next);
-        }
+NFA::NFA() : states(), start(-1), classes() {}
+
+int NFA::addState() {
+    int id = states.size();
+    return states.allocate(NFAState(id));
+}
 
-        for (NFAState* next : current->epsilonTransitions)
-            queue.push(next);
+void NFA::addTransition(int from, const std::bitset<256>& chars, int to) {
+    states[from].chars = chars;
+    states[from].out = to;
+}
+
+void NFA::addEpsilon(int from, int to) {
+    NFAState& state = states[from];
+
+    if (state.epsilon[0] == -1)
+        state.epsilon[0] = to;
+    else if (state.epsilon[1] == -1)
+        state.epsilon[1] = to;
+    else
+        throw std::runtime_error("NFA state " + std::to_string(from) + " has more than two epsilon transitions");
+}
+
+/*
+Lists, for every state with a byte transition, the byte classes that take
+it, so subset construction can bucket moves without scanning 256 bits.
+*/
+void NFA::computeClasses() {
+    int width = classes.getCount();
+
+    transitionClasses.clear();
+    for (size_t id = 0; id < states.size(); id++) {
+        NFAState& state = states[id];
+        state.classBegin = transitionClasses.size();
+        if (state.out != -1) {
+            for (int cls = 0; cls < width; cls++) {
+                if (state.chars.test(classes.representative(cls)))
+                    transitionClasses.push_back(cls);
+            }
+        }
+        state.classEnd = transitionClasses.size();
     }
 }
 
-NFA::~NFA() {
-    for (NFAState* state : states)
-        delete state;
+/*
+Precomputes the epsilon-closure of every state. Tarjan's algorithm finds
+the strongly connected components of the epsilon graph (the loops built by
+StarNode and PlusNode) and emits them in reverse topological order, so the
+closure of a component is its members plus the already computed closures
+of the components it points to. All states of a component share one
+closure.
+*/
+void NFA::computeClosures() {
+    int n = states.size();
+    std::vector<int> index(n, -1);
+    std::vector<int> low(n, 0);
+    std::vector<bool> onStack(n, false);
+    std::vector<int> stack;
+    std::vector<std::pair<int, int>> callStack;
+    StateMarks marks(n);
+    int counter = 0;
+
+    sccOf.assign(n, -1);
+    for (int root = 0; root < n; root++) {
+        if (index[root] != -1)
+            continue ;
+
+        index[root] = low[root] = counter++;
+        stack.push_back(root);
+        onStack[root] = true;
+        callStack.push_back(std::make_pair(root, 0));
+
+        while (!callStack.empty()) {
+            int v = callStack.back().first;
+            int edge = callStack.back().second;
+
+            if (edge < 2 && states[v].epsilon[edge] != -1) {
+                int w = states[v].epsilon[edge];
+                callStack.back().second++;
+                if (index[w] == -1) {
+                    index[w] = low[w] = counter++;
+                    stack.push_back(w);
+                    onStack[w] = true;
+                    callStack.push_back(std::make_pair(w, 0));
+                } else if (onStack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue ;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty())
+                low[callStack.back().first] = std::min(low[callStack.back().first], low[v]);
+            if (low[v] != index[v])
+                continue ;
+
+            int scc = closures.size();
+            std::vector<int> members;
+            int member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                onStack[member] = false;
+                sccOf[member] = scc;
+                members.push_back(member);
+            } while (member != v);
+
+            StateSet closure;
+            marks.clear();
+            for (int m : members) {
+                if (marks.insert(m))
+                    closure.push_back(m);
+                for (int e = 0; e < 2 && states[m].epsilon[e] != -1; e++) {
+                    int next = states[m].epsilon[e];
+                    if (sccOf[next] == scc)
+                        continue ;
+                    for (int id : closures[sccOf[next]]) {
+                        if (marks.insert(id))
+                            closure.push_back(id);
+                    }
+                }
+            }
+            std::sort(closure.begin(), closure.end());
+            closures.push_back(closure);
+        }
+    }
 }
 
-NFAState *NFA::getStart() const {
+int NFA::getStart() const {
     return start;
 }
 
-std::set<NFAState*> NFA::getStates() const {
-    return states;
+const NFAState& NFA::getState(int id) const {
+    return states[id];
 }
 
+size_t NFA::getStateCount() const {
+    return states.size();
+}
+
+const int *NFA::getTransitionClasses(int id) const {
+    return transitionClasses.data() + states[id].classBegin;
+}
+
+const StateSet& NFA::getClosure(int id) const {
+    return closures[sccOf[id]];
+}
+
+const ByteClasses& NFA::getClasses() const {
+    return classes;
+}
+
+/*
+Rules hang off a chain of split states (two epsilon transitions each)
+rather than one start state with an edge per rule.
+*/
 NFA NFA::combineRules(const std::vector<Rule>& rules) {
-    int stateCounter = 0;
-    NFAState* globalStart = new NFAState(stateCounter++);
+    NFA nfa;
 
-    for (const Rule& rule : rules) {
-        NFAFragment frag = rule.pattern->toNFA(stateCounter);
+    for (const Rule& rule : rules)
+        rule.pattern->collectByteClasses(nfa.classes);
 
-        frag.end->accepting = true;
-        frag.end->ruleNumber = rule.priority;
+    nfa.start = nfa.addState();
+    int split = nfa.start;
+    for (size_t i = 0; i < rules.size(); i++) {
+        NFAFragment frag = rules[i].pattern->toNFA(nfa);
 
-        globalStart->epsilonTransitions.insert(frag.start);
+        nfa.states[frag.end].accepting = true;
+        nfa.states[frag.end].ruleNumber = rules[i].priority;
+
+        nfa.addEpsilon(split, frag.start);
+        if (i + 1 < rules.size()) {
+            int rest = nfa.addState();
+            nfa.addEpsilon(split, rest);
+            split = rest;
+        }
     }
-    
-    return NFA(globalStart);
-}
 
+    nfa.computeClasses();
+    nfa.computeClosures();
+    return nfa;
+}
@@ -1,20 +1,51 @@
 #include "../../inc/parser/Parser.hpp"
+#include "../../inc/utils/StringUtils.hpp"
 
-Rule::Rule(RegexNode *p, const std::string &action, int priority)
-    : pattern(p), action(action), priority(priority) {}
+Rule::Rule(RegexNode *p, const std::string &action, int priority, int line)
+    : pattern(p), action(action), priority(priority), line(line) {}
 
-Parser::Parser(const std::vector<Token> &tokens) : _tokens(tokens), _definitions(), _pos(0) {}
+Parser::Parser(const Tokenizer& tokenizer)
+    :   _sources(1, tokenizer), _origins(), _lookahead(), _definitions(), _headerCode(), _userCode() {}
 
-Token Parser::peek() const {
-    return _tokens.at(_pos);
+Parser::~Parser() {
+    for (std::map<std::string, RegexNode *>::iterator it = _definitions.begin(); it != _definitions.end(); ++it)
+        delete it->second;
+}
+
+/*
+The next token from the innermost source. Tokens of a definition's
+pattern take the position of the definition line.
+*/
+Token Parser::fetch() {
+    Token token = _sources.back().next();
+
+    if (!_origins.empty()) {
+        token.line = _origins.back().line;
+        token.column = _origins.back().column;
+    }
+    return token;
+}
+
+const Token& Parser::peek() {
+    if (_lookahead.empty())
+        _lookahead.push_back(fetch());
+    return _lookahead.front();
+}
+
+const Token& Parser::peekNext() {
+    while (_lookahead.size() < 2)
+        _lookahead.push_back(fetch());
+    return _lookahead[1];
 }
 
 Token Parser::advance() {
-    return _tokens.at(_pos++);
+    Token token = peek();
+    _lookahead.pop_front();
+    return token;
 }
 
-bool Parser::isAtEnd() const {
-    return (_pos >= _tokens.size() || _tokens.at(_pos).type == TOK_EOF);
+bool Parser::isAtEnd() {
+    return peek().type == TOK_EOF;
 }
 
 void Parser::parseHeader() {
@@ -25,68 +56,68 @@ void Parser::parseHeader() {
         }
 
         if (peek().type == TOK_PERCENT_LBRACE) {
-            while (peek().type != TOK_PERCENT_RBRACE)
-                advance();
+            while (peek().type != TOK_PERCENT_RBRACE) {
+                Token token = advance();
+                if (token.type == TOK_C_CODE)
+                    _headerCode += token.value;
+            }
             advance();
             continue;
         }
 
         if (peek().type == TOK_DEFINITION) {
             Token defToken = advance();
-            size_t space = defToken.value.find(' ');
-            std::string name = defToken.value.substr(0, space);
-            std::string pattern = defToken.value.substr(space + 1);
-            _definitions[name] = expandDefinitions(pattern, defToken);
+            size_t space = defToken.value.find_first_of(" \t");
+            size_t start = defToken.value.find_first_not_of(" \t", space);
+            std::string name(defToken.value.substr(0, space));
+            RegexNode *pattern = parseDefinition(start == std::string_view::npos ? "" : defToken.value.substr(start), defToken);
+            std::map<std::string, RegexNode *>::iterator it = _definitions.find(name);
+            if (it != _definitions.end()) {
+                delete it->second;
+                it->second = pattern;
+            } else
+                _definitions[name] = pattern;
         }
     }
 }
 
-std::string Parser::expandDefinitions(const std::string& pattern, const Token& defToken) {
+/*
+Parses a definition's pattern on its own, so a reference to it acts as
+one parenthesized group. References inside it resolve to the definitions
+already parsed.
+*/
+RegexNode *Parser::parseDefinition(std::string_view pattern, const Token& defToken) {
+    _sources.push_back(Tokenizer::forPattern(pattern));
+    _origins.push_back(defToken);
+    RegexNode *node = parsePattern();
+    if (!isAtEnd()) {
+        delete node;
+        throw std::runtime_error("unexpected token in definition at " +
+            std::to_string(defToken.line) + ":" + std::to_string(defToken.column));
+    }
+    _lookahead.clear();
+    _sources.pop_back();
+    _origins.pop_back();
+    return node;
+}
+
+/*
+The characters a string or escape token stands for.
+*/
+std::string Parser::unescape(std::string_view raw) {
     std::string result;
     size_t i = 0;
 
-    while (i < pattern.size()) {
-        if (pattern[i] == '{') {
-            size_t end = pattern.find('}', i);
-            if (end == std::string::npos)
-                throw std::runtime_error("unterminated { at " + 
-                    std::to_string(defToken.line) + ":" + std::to_string(defToken.column));
-            std::string name = pattern.substr(i + 1, end - i - 1);
-            if (_definitions.find(name) == _definitions.end())
-                throw std::runtime_error("undefined: " + name + " at " + 
-                    std::to_string(defToken.line) + ":" + std::to_string(defToken.column));
-            result += expandDefinitions(_definitions[name], defToken);
-            i = end + 1;
-        } else {
-            result += pattern[i];
+    while (i < raw.size()) {
+        if (raw[i] == '\\') {
             i++;
-        }
+            result += unescapeChar(raw, i);
+        } else
+            result += raw[i++];
     }
     return result;
 }
 
-void Parser::expandReferences() {
-    for (size_t i = 0; i < _tokens.size(); i++) {
-        if (_tokens[i].type == TOK_DEFINITION_REFERENCE) {
-            std::string name = _tokens[i].value;
-            if (_definitions.find(name) == _definitions.end())
-                throw std::runtime_error("undefined reference: " + name + " at " + 
-                    std::to_string(_tokens[i].line) + ":" + std::to_string(_tokens[i].column));
-            
-            std::string pattern = _definitions[name];
-            Tokenizer t(pattern);
-            std::vector<Token> expanded = t.tokenizePatternExtern();
-            
-            if (!expanded.empty() && expanded.back().type == TOK_EOF)
-                expanded.pop_back();
-            
-            _tokens.erase(_tokens.begin() + i);
-            _tokens.insert(_tokens.begin() + i, expanded.begin(), expanded.end());
-            i += expanded.size() - 1;
-        }
-    }
-}
-
 RegexNode *Parser::parsePattern() {
     return parseAlt();
 }
@@ -94,7 +125,7 @@ RegexNode *Parser::parsePattern() {
 RegexNode *Parser::parseAlt() {
     RegexNode *left = parseConcat();
     while (!isAtEnd() && peek().type == TOK_PIPE) {
-        if (_pos + 1 < _tokens.size() && _tokens[_pos + 1].type == TOK_NEWLINE)
+        if (peekNext().type == TOK_NEWLINE)
             return left;
         advance();
         RegexNode *right = parseConcat();
@@ -130,12 +161,45 @@ RegexNode *Parser::parsePostfix() {
         case (TOK_QUESTION):
             advance();
             return new QuestionNode(node);
+        case (TOK_REPEAT):
+            return parseRepeat(node, advance());
         default:
             return node;
     }
     return node;
 }
 
+/*
+{n}, {n,} or {n,m} after node. The bounds that are plain closures
+become one.
+*/
+RegexNode *Parser::parseRepeat(RegexNode *node, const Token& token) {
+    std::string_view value = token.value;
+    size_t comma = value.find(',');
+    std::string_view low = value.substr(0, comma);
+    std::string_view high = comma == std::string_view::npos ? low : value.substr(comma + 1);
+    bool valid = !low.empty() && low.size() <= 5 && high.size() <= 5 && high.find(',') == std::string_view::npos;
+    int min = valid ? std::stoi(std::string(low)) : 0;
+    int max = valid && !high.empty() ? std::stoi(std::string(high)) : RepeatNode::UNBOUNDED;
+
+    if (!valid || min > RepeatNode::MAX_COUNT || max > RepeatNode::MAX_COUNT
+        || (max != RepeatNode::UNBOUNDED && max < min)) {
+        delete node;
+        throw std::runtime_error("bad repetition {" + std::string(value) + "} at " +
+            std::to_string(token.line) + ":" + std::to_string(token.column));
+    }
+
+    if (min == 1 && max == 1)
+        return node;
+    if (min == 0 && max == RepeatNode::UNBOUNDED)
+        return new StarNode(node);
+    if (min == 1 && max == RepeatNode::UNBOUNDED)
+        return new PlusNode(node);
+    if (min == 0 && max == 1)
+        return new QuestionNode(node);
+    return new RepeatNode(node, min, max);
+}
+
 RegexNode *Parser::parsePrimary() {
     Token token = advance();
 
@@ -144,15 +208,16 @@ RegexNode *Parser::parsePrimary() {
             if (token.value.empty())
                 throw std::runtime_error("empty literal at " + 
                     std::to_string(token.line) + ":" + std::to_string(token.column));
-            return new LiteralNode(token.value[0]);
+            return new LiteralNode(unescape(token.value)[0]);
         }
         case (TOK_STRING): {
-            if (token.value.empty())
+            std::string text = unescape(token.value);
+            if (text.empty())
                 throw std::runtime_error("empty string at " + 
                     std::to_string(token.line) + ":" + std::to_string(token.column));
-            RegexNode *result = new LiteralNode(token.value[0]);
-            for (size_t i = 1; i < token.value.length(); i++)
-                result = new ConcatNode(result, new LiteralNode(token.value[i]));
+            RegexNode *result = new LiteralNode(text[0]);
+            for (size_t i = 1; i < text.length(); i++)
+                result = new ConcatNode(result, new LiteralNode(text[i]));
             return result;
         }
         case (TOK_CHARCLASS): {
@@ -160,11 +225,7 @@ RegexNode *Parser::parsePrimary() {
                 throw std::runtime_error("empty charclass at " + 
                     std::to_string(token.line) + ":" + std::to_string(token.column));
             bool negated = (token.value[0] == '^');
-            std::string pattern;
-            if (negated)
-                pattern = token.value.substr(1);
-            else
-                pattern = token.value;
+            std::string pattern(negated ? token.value.substr(1) : token.value);
             return new CharClassNode(pattern, negated);
         }
         case (TOK_LPAREN): {
@@ -176,6 +237,13 @@ RegexNode *Parser::parsePrimary() {
         }
         case (TOK_DOT):
             return new DotNode();
+        case (TOK_DEFINITION_REFERENCE): {
+            std::map<std::string, RegexNode *>::const_iterator it = _definitions.find(std::string(token.value));
+            if (it == _definitions.end())
+                throw std::runtime_error("undefined reference: " + std::string(token.value) + " at " +
+                    std::to_string(token.line) + ":" + std::to_string(token.column));
+            return it->second->clone();
+        }
         
         default:
             throw std::runtime_error("unexpected token at " + std::to_string(token.line) + ":" + std::to_string(token.column));
@@ -186,7 +254,7 @@ RegexNode *Parser::parsePrimary() {
 pattern     → alternation
 alternation → concat ('|' concat)*
 concat      → postfix postfix*
-postfix     → primary ('*' | '+' | '?')?
+postfix     → primary ('*' | '+' | '?' | '{' n (',' m?)? '}')?
 primary     → LITERAL | STRING | CHARCLASS | '(' pattern ')' | '{' NAME '}'
 */
 
@@ -205,14 +273,15 @@ std::vector<Rule> Parser::parseRules() {
             break ;
         }
 
+        int line = peek().line;
         RegexNode *pattern = parsePattern();
         
         if (peek().type == TOK_PIPE) {
-            std::string action = advance().value;  // "|"
-            rules.push_back(Rule(pattern, action, priority++));
+            std::string action(advance().value);  // "|"
+            rules.push_back(Rule(pattern, action, priority++, line));
         } else if (peek().type == TOK_C_CODE) {
-            std::string action = advance().value;
-            rules.push_back(Rule(pattern, action, priority++));
+            std::string action(advance().value);
+            rules.push_back(Rule(pattern, action, priority++, line));
         } else {
             throw std::runtime_error("expected action at " + 
                 std::to_string(peek().line) + ":" + std::to_string(peek().column));
@@ -241,8 +310,17 @@ void Parser::resolveActions(std::vector<Rule>& rules) {
 
 std::vector<Rule> Parser::parse() {
     parseHeader();
-    expandReferences();
     std::vector<Rule> rules = parseRules();
     resolveActions(rules);
+    if (!isAtEnd() && peek().type == TOK_C_CODE)
+        _userCode = std::string(advance().value);
     return rules;
 }
+
+const std::string& Parser::getHeaderCode() const {
+    return _headerCode;
+}
+
+const std::string& Parser::getUserCode() const {
+    return _userCode;
+}
@@ -1,18 +1,35 @@
 #include "../../inc/regex/AltNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
 
 AltNode::AltNode(RegexNode *l, RegexNode *r) : BinaryNode(l, r) {}
 
-NFAFragment AltNode::toNFA(int& stateCounter) {
-    NFAFragment left = this->left->toNFA(stateCounter);
-    NFAFragment right = this->right->toNFA(stateCounter);
+RegexNode *AltNode::clone() const {
+    return new AltNode(left->clone(), right->clone());
+}
 
-    NFAState *start = new NFAState(stateCounter++);
-    NFAState *end = new NFAState(stateCounter++);
+NFAFragment AltNode::toNFA(NFA& nfa) const {
+    NFAFragment left = this->left->toNFA(nfa);
+    NFAFragment right = this->right->toNFA(nfa);
 
-    start->epsilonTransitions.insert(left.start);
-    start->epsilonTransitions.insert(right.start);
-    left.end->epsilonTransitions.insert(end);
-    right.end->epsilonTransitions.insert(end);
+    int start = nfa.addState();
+    int end = nfa.addState();
+
+    nfa.addEpsilon(start, left.start);
+    nfa.addEpsilon(start, right.start);
+    nfa.addEpsilon(left.end, end);
+    nfa.addEpsilon(right.end, end);
 
     return NFAFragment(start, end);
-}
\ No newline at end of file
+}
+
+PositionInfo AltNode::computePositions(PositionTable& table) const {
+    PositionInfo left = this->left->computePositions(table);
+    PositionInfo right = this->right->computePositions(table);
+    PositionInfo info;
+
+    info.nullable = left.nullable || right.nullable;
+    info.firstpos = PositionTable::merge(left.firstpos, right.firstpos);
+    info.lastpos = PositionTable::merge(left.lastpos, right.lastpos);
+    return info;
+}
@@ -0,0 +1,48 @@
+#include "../../inc/regex/ByteClasses.hpp"
+
+ByteClasses::ByteClasses() : count(1) {
+    for (int c = 0; c < 256; c++)
+        classOf[c] = 0;
+    first[0] = 0;
+}
+
+void ByteClasses::refine(const std::bitset<256>& chars) {
+    std::vector<int> inside(count, -1);
+    std::vector<int> outside(count, -1);
+    int next = 0;
+
+    for (int c = 0; c < 256; c++) {
+        std::vector<int>& split = chars.test(c) ? inside : outside;
+        if (split[classOf[c]] == -1) {
+            first[next] = (unsigned char)c;
+            split[classOf[c]] = next++;
+        }
+        classOf[c] = split[classOf[c]];
+    }
+    count = next;
+}
+
+int ByteClasses::getClass(unsigned char c) const {
+    return classOf[c];
+}
+
+const int *ByteClasses::getMap() const {
+    return classOf;
+}
+
+int ByteClasses::getCount() const {
+    return count;
+}
+
+unsigned char ByteClasses::representative(int cls) const {
+    return first[cls];
+}
+
+std::vector<unsigned char> ByteClasses::members(int cls) const {
+    std::vector<unsigned char> result;
+    for (int c = 0; c < 256; c++) {
+        if (classOf[c] == cls)
+            result.push_back((unsigned char)c);
+    }
+    return result;
+}
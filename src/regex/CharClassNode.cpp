@@ -1,8 +1,40 @@
 #include "../../inc/regex/CharClassNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
+#include "../../inc/utils/StringUtils.hpp"
+#include <cctype>
 
 CharClassNode::CharClassNode(const std::string& pattern, bool negated)
     : pattern(pattern), negated(negated) {}
 
+/*
+A class matching exactly chars, its pattern written as ranges with every
+byte that is not alphanumeric in \xHH form.
+*/
+CharClassNode *CharClassNode::fromChars(const std::bitset<256>& chars) {
+    static const char hex[] = "0123456789abcdef";
+    std::string pattern;
+
+    for (int c = 0; c < 256; c++) {
+        if (!chars.test(c))
+            continue ;
+        int high = c;
+        while (high + 1 < 256 && chars.test(high + 1))
+            high++;
+        for (int end : { c, high }) {
+            if (std::isalnum(end))
+                pattern += (char)end;
+            else
+                pattern += std::string("\\x") + hex[end >> 4] + hex[end & 15];
+            if (end == high)
+                break ;
+            pattern += '-';
+        }
+        c = high;
+    }
+    return new CharClassNode(pattern, false);
+}
+
 const std::string& CharClassNode::getPattern() const {
     return pattern;
 }
@@ -11,39 +43,104 @@ bool CharClassNode::isNegated() const {
     return negated;
 }
 
-std::set<char> CharClassNode::expandCharClass(const std::string& pattern) {
+/*
+Adds the members of a POSIX bracket class such as [:alpha:] to result.
+*/
+static void addPosixClass(const std::string& name, std::set<char>& result) {
+    static const struct {
+        const char *name;
+        int (*test)(int);
+    } classes[] = {
+        { "alpha", isalpha }, { "digit", isdigit }, { "alnum", isalnum },
+        { "upper", isupper }, { "lower", islower }, { "space", isspace },
+        { "blank", isblank }, { "punct", ispunct }, { "print", isprint },
+        { "graph", isgraph }, { "cntrl", iscntrl }, { "xdigit", isxdigit },
+    };
+
+    for (const auto& posix : classes) {
+        if (name != posix.name)
+            continue ;
+        for (int c = 0; c < 128; c++) {
+            if (posix.test(c))
+                result.insert((char)c);
+        }
+        return ;
+    }
+    throw std::runtime_error("unknown character class [:" + name + ":]");
+}
+
+static char classChar(const std::string& pattern, size_t& i) {
+    if (pattern[i] == '\\' && i + 1 < pattern.length()) {
+        i++;
+        return unescapeChar(pattern, i);
+    }
+    return pattern[i++];
+}
+
+std::set<char> CharClassNode::expandCharClass(const std::string& pattern) const {
     std::set<char> result;
+    size_t i = 0;
 
-    for (size_t i = 0; i < pattern.length(); i++) {
-        if (i + 2 < pattern.length() && pattern[i + 1] == '-') {
-            for (char c = pattern[i]; c <= pattern[i + 2]; c++)
-                result.insert(c);
-            i += 2;
+    while (i < pattern.length()) {
+        if (pattern.compare(i, 2, "[:") == 0) {
+            size_t end = pattern.find(":]", i + 2);
+            if (end != std::string::npos) {
+                addPosixClass(pattern.substr(i + 2, end - i - 2), result);
+                i = end + 2;
+                continue ;
+            }
         }
-        else {
-            result.insert(pattern[i]);
+
+        int low = (unsigned char)classChar(pattern, i);
+        int high = low;
+        if (i + 1 < pattern.length() && pattern[i] == '-') {
+            i++;
+            high = (unsigned char)classChar(pattern, i);
         }
+        for (int c = low; c <= high; c++)
+            result.insert((char)c);
     }
 
     if (isNegated()) {
         std::set<char> temp = result;
         result.clear();
-        for (char c = 0; c < 256; c++) {
-            if (c != '\n' && temp.find(c) == temp.end())
-                result.insert(c);
+        for (int c = 0; c < 256; c++) {
+            if (c != '\n' && temp.find((char)c) == temp.end())
+                result.insert((char)c);
         }
     }
     return result;
 }
 
-NFAFragment CharClassNode::toNFA(int& stateCounter) {
-    NFAState *start = new NFAState(stateCounter++);
-    NFAState *end = new NFAState(stateCounter++);
+std::bitset<256> CharClassNode::getChars() const {
+    std::bitset<256> chars;
+    for (char c : expandCharClass(pattern))
+        chars.set((unsigned char)c);
+    return chars;
+}
+
+void CharClassNode::collectByteClasses(ByteClasses& classes) const {
+    classes.refine(getChars());
+}
 
-    std::set<char> chars = expandCharClass(pattern);
+RegexNode *CharClassNode::clone() const {
+    return new CharClassNode(pattern, negated);
+}
 
-    for (char c : chars)
-        start->transitions[c].insert(end);
+NFAFragment CharClassNode::toNFA(NFA& nfa) const {
+    int start = nfa.addState();
+    int end = nfa.addState();
+
+    nfa.addTransition(start, getChars(), end);
 
     return NFAFragment(start, end);
-}
\ No newline at end of file
+}
+
+PositionInfo CharClassNode::computePositions(PositionTable& table) const {
+    PositionInfo info;
+    int pos = table.addPosition(getChars());
+
+    info.firstpos.push_back(pos);
+    info.lastpos.push_back(pos);
+    return info;
+}
@@ -1,10 +1,28 @@
 #include "../../inc/regex/ConcatNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
 
 ConcatNode::ConcatNode(RegexNode *l, RegexNode *r) : BinaryNode(l, r) {}
 
-NFAFragment ConcatNode::toNFA(int &stateCounter) {
-    NFAFragment left = this->left->toNFA(stateCounter);
-    NFAFragment right = this->right->toNFA(stateCounter);
-    left.end->epsilonTransitions.insert(right.start);
+RegexNode *ConcatNode::clone() const {
+    return new ConcatNode(left->clone(), right->clone());
+}
+
+NFAFragment ConcatNode::toNFA(NFA& nfa) const {
+    NFAFragment left = this->left->toNFA(nfa);
+    NFAFragment right = this->right->toNFA(nfa);
+    nfa.addEpsilon(left.end, right.start);
     return NFAFragment(left.start, right.end);
-}
\ No newline at end of file
+}
+
+PositionInfo ConcatNode::computePositions(PositionTable& table) const {
+    PositionInfo left = this->left->computePositions(table);
+    PositionInfo right = this->right->computePositions(table);
+    PositionInfo info;
+
+    table.addFollow(left.lastpos, right.firstpos);
+    info.nullable = left.nullable && right.nullable;
+    info.firstpos = left.nullable ? PositionTable::merge(left.firstpos, right.firstpos) : left.firstpos;
+    info.lastpos = right.nullable ? PositionTable::merge(left.lastpos, right.lastpos) : right.lastpos;
+    return info;
+}
@@ -1,13 +1,38 @@
 #include "../../inc/regex/DotNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
 
-NFAFragment DotNode::toNFA(int& stateCounter) {
-    NFAState* start = new NFAState(stateCounter++);
-    NFAState* end = new NFAState(stateCounter++);
-    
-    for (char c = 0; c < 256; c++) {
-        if (c != '\n')
-            start->transitions[c].insert(end);
-    }
+void DotNode::collectByteClasses(ByteClasses& classes) const {
+    std::bitset<256> chars;
+    chars.set((unsigned char)'\n');
+    classes.refine(chars);
+}
+
+RegexNode *DotNode::clone() const {
+    return new DotNode();
+}
+
+NFAFragment DotNode::toNFA(NFA& nfa) const {
+    int start = nfa.addState();
+    int end = nfa.addState();
+    std::bitset<256> chars;
+
+    chars.set();
+    chars.reset((unsigned char)'\n');
+    nfa.addTransition(start, chars, end);
     
     return {start, end};
-}
\ No newline at end of file
+}
+
+PositionInfo DotNode::computePositions(PositionTable& table) const {
+    PositionInfo info;
+    std::bitset<256> chars;
+
+    chars.set();
+    chars.reset((unsigned char)'\n');
+    int pos = table.addPosition(chars);
+
+    info.firstpos.push_back(pos);
+    info.lastpos.push_back(pos);
+    return info;
+}
@@ -1,4 +1,6 @@
 #include "../../inc/regex/LiteralNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
 
 LiteralNode::LiteralNode(char c) : ch(c) {}
 
@@ -6,9 +8,33 @@ char LiteralNode::getChar() const {
     return ch;
 }
 
-NFAFragment LiteralNode::toNFA(int& stateCounter) {
-    NFAState *start = new NFAState(stateCounter++);
-    NFAState *end = new NFAState(stateCounter++);
-    start->transitions[ch].insert(end);
+void LiteralNode::collectByteClasses(ByteClasses& classes) const {
+    std::bitset<256> chars;
+    chars.set((unsigned char)ch);
+    classes.refine(chars);
+}
+
+RegexNode *LiteralNode::clone() const {
+    return new LiteralNode(ch);
+}
+
+NFAFragment LiteralNode::toNFA(NFA& nfa) const {
+    int start = nfa.addState();
+    int end = nfa.addState();
+    std::bitset<256> chars;
+    chars.set((unsigned char)ch);
+    nfa.addTransition(start, chars, end);
     return NFAFragment(start, end);
-}
\ No newline at end of file
+}
+
+PositionInfo LiteralNode::computePositions(PositionTable& table) const {
+    PositionInfo info;
+    std::bitset<256> chars;
+
+    chars.set((unsigned char)ch);
+    int pos = table.addPosition(chars);
+
+    info.firstpos.push_back(pos);
+    info.lastpos.push_back(pos);
+    return info;
+}
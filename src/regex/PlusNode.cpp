@@ -1,17 +1,30 @@
 #include "../../inc/regex/PlusNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
 
 PlusNode::PlusNode(RegexNode *c) : UnaryNode(c) {}
 
-NFAFragment PlusNode::toNFA(int& stateCounter) {
-    NFAFragment child = this->child->toNFA(stateCounter);
+RegexNode *PlusNode::clone() const {
+    return new PlusNode(child->clone());
+}
+
+NFAFragment PlusNode::toNFA(NFA& nfa) const {
+    NFAFragment child = this->child->toNFA(nfa);
     
-    NFAState *start = new NFAState(stateCounter++);
-    NFAState *end = new NFAState(stateCounter++);
+    int start = nfa.addState();
+    int end = nfa.addState();
 
-    start->epsilonTransitions.insert(child.start);
-    child.end->epsilonTransitions.insert(child.start);
-    child.end->epsilonTransitions.insert(end);
+    nfa.addEpsilon(start, child.start);
+    nfa.addEpsilon(child.end, child.start);
+    nfa.addEpsilon(child.end, end);
 
     return NFAFragment(start, end);
 
 }
+
+PositionInfo PlusNode::computePositions(PositionTable& table) const {
+    PositionInfo info = this->child->computePositions(table);
+
+    table.addFollow(info.lastpos, info.firstpos);
+    return info;
+}
@@ -0,0 +1,64 @@
+#include "../../inc/regex/Positions.hpp"
+#include <algorithm>
+
+PositionInfo::PositionInfo() : nullable(false), firstpos(), lastpos() {}
+
+PositionTable::PositionTable() : chars(), rules(), followpos(), classes() {}
+
+int PositionTable::addPosition(const std::bitset<256>& set) {
+    chars.push_back(set);
+    rules.push_back(-1);
+    followpos.push_back(std::vector<int>());
+    return chars.size() - 1;
+}
+
+int PositionTable::addEndMarker(int rule) {
+    int pos = addPosition(std::bitset<256>());
+    rules[pos] = rule;
+    return pos;
+}
+
+void PositionTable::addFollow(const std::vector<int>& from, const std::vector<int>& to) {
+    for (int pos : from)
+        followpos[pos].insert(followpos[pos].end(), to.begin(), to.end());
+}
+
+/*
+Sorts and deduplicates the followpos lists and records which byte classes
+each position matches.
+*/
+void PositionTable::finish(const ByteClasses& byteClasses) {
+    classes.assign(chars.size(), std::vector<int>());
+    for (size_t pos = 0; pos < chars.size(); pos++) {
+        std::vector<int>& follow = followpos[pos];
+        std::sort(follow.begin(), follow.end());
+        follow.erase(std::unique(follow.begin(), follow.end()), follow.end());
+
+        for (int cls = 0; cls < byteClasses.getCount(); cls++) {
+            if (chars[pos].test(byteClasses.representative(cls)))
+                classes[pos].push_back(cls);
+        }
+    }
+}
+
+size_t PositionTable::size() const {
+    return chars.size();
+}
+
+int PositionTable::getRule(int pos) const {
+    return rules[pos];
+}
+
+const std::vector<int>& PositionTable::getFollow(int pos) const {
+    return followpos[pos];
+}
+
+const std::vector<int>& PositionTable::getClasses(int pos) const {
+    return classes[pos];
+}
+
+std::vector<int> PositionTable::merge(const std::vector<int>& a, const std::vector<int>& b) {
+    std::vector<int> result;
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
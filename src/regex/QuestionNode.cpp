@@ -1,16 +1,29 @@
 #include "../../inc/regex/QuestionNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
 
 QuestionNode::QuestionNode(RegexNode *c) : UnaryNode(c) {}
 
-NFAFragment QuestionNode::toNFA(int& stateCounter) {
-    NFAFragment child = this->child->toNFA(stateCounter);
+RegexNode *QuestionNode::clone() const {
+    return new QuestionNode(child->clone());
+}
 
-    NFAState *start = new NFAState(stateCounter++);
-    NFAState *end = new NFAState(stateCounter++);
+NFAFragment QuestionNode::toNFA(NFA& nfa) const {
+    NFAFragment child = this->child->toNFA(nfa);
 
-    start->epsilonTransitions.insert(child.start);
-    start->epsilonTransitions.insert(end);
-    child.end->epsilonTransitions.insert(end);
+    int start = nfa.addState();
+    int end = nfa.addState();
+
+    nfa.addEpsilon(start, child.start);
+    nfa.addEpsilon(start, end);
+    nfa.addEpsilon(child.end, end);
 
     return NFAFragment(start, end);
-}
\ No newline at end of file
+}
+
+PositionInfo QuestionNode::computePositions(PositionTable& table) const {
+    PositionInfo info = this->child->computePositions(table);
+
+    info.nullable = true;
+    return info;
+}
@@ -1,8 +1,12 @@
 #include "../../inc/regex/RegexNode.hpp"
 
-NFAState::NFAState(int id) : id(id), accepting(false), ruleNumber(-1) {}
+NFAState::NFAState(int id)
+    :   id(id), chars(), out(-1), classBegin(0), classEnd(0), accepting(false), ruleNumber(-1) {
+    epsilon[0] = -1;
+    epsilon[1] = -1;
+}
 
-NFAFragment::NFAFragment(NFAState *start, NFAState *end) : start(start), end(end) {}
+NFAFragment::NFAFragment(int start, int end) : start(start), end(end) {}
 
 UnaryNode::UnaryNode(RegexNode *c) : child(c) {}
 
@@ -10,10 +14,22 @@ UnaryNode::~UnaryNode() {
     delete child;
 }
 
+void UnaryNode::collectByteClasses(ByteClasses& classes) const {
+    child->collectByteClasses(classes);
+}
+
 RegexNode *UnaryNode::getChild() const {
     return child;
 }
 
+/*
+Forgets the child without deleting it, for nodes whose children are
+shared and owned elsewhere.
+*/
+void UnaryNode::detach() {
+    child = NULL;
+}
+
 BinaryNode::BinaryNode(RegexNode *l, RegexNode *r) : left(l), right(r) {}
 
 BinaryNode::~BinaryNode() {
@@ -21,6 +37,11 @@ BinaryNode::~BinaryNode() {
     delete right;
 }
 
+void BinaryNode::collectByteClasses(ByteClasses& classes) const {
+    left->collectByteClasses(classes);
+    right->collectByteClasses(classes);
+}
+
 RegexNode *BinaryNode::getLeft() const {
     return left;
 }
@@ -29,9 +50,7 @@ RegexNode *BinaryNode::getRight() const {
     return right;
 }
 
-
-
-
-
-
-
+void BinaryNode::detach() {
+    left = NULL;
+    right = NULL;
+}
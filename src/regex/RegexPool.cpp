@@ -0,0 +1,225 @@
+#include "../../inc/regex/RegexPool.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+bool RegexPool::Key::operator==(const Key& other) const {
+    return kind == other.kind && left == other.left && right == other.right && bytes == other.bytes;
+}
+
+size_t RegexPool::KeyHash::operator()(const Key& key) const {
+    size_t hash = 14695981039346656037ULL;
+
+    for (size_t value : { (size_t)key.kind, (size_t)key.left, (size_t)key.right }) {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    }
+    for (unsigned char c : key.bytes) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+RegexPool::RegexPool() : _nodes(), _ids(), _owned(), _treeNodes(0) {}
+
+/*
+Children are shared, so each node is detached from them before it is
+deleted and every node is deleted exactly once.
+*/
+RegexPool::~RegexPool() {
+    for (RegexNode *node : _owned) {
+        if (UnaryNode *unary = dynamic_cast<UnaryNode *>(node))
+            unary->detach();
+        else if (BinaryNode *binary = dynamic_cast<BinaryNode *>(node))
+            binary->detach();
+        delete node;
+    }
+}
+
+/*
+Takes ownership of tree and returns its node in the DAG.
+*/
+RegexNode *RegexPool::intern(RegexNode *tree) {
+    RegexNode *node = canonical(tree);
+
+    delete tree;
+    return node;
+}
+
+size_t RegexPool::getNodeCount() const {
+    return _owned.size();
+}
+
+size_t RegexPool::getTreeNodeCount() const {
+    return _treeNodes;
+}
+
+RegexNode *RegexPool::canonical(const RegexNode *node) {
+    std::bitset<256> set;
+
+    _treeNodes++;
+    if (const LiteralNode *literalNode = dynamic_cast<const LiteralNode *>(node))
+        return literal(literalNode->getChar());
+    if (dynamic_cast<const DotNode *>(node))
+        return dot();
+    if (dynamic_cast<const CharClassNode *>(node) && singleByte(node, set))
+        return chars(set, node);
+    if (const ConcatNode *concatNode = dynamic_cast<const ConcatNode *>(node))
+        return concat(canonical(concatNode->getLeft()), canonical(concatNode->getRight()));
+    if (const AltNode *altNode = dynamic_cast<const AltNode *>(node))
+        return alt(canonical(altNode->getLeft()), canonical(altNode->getRight()));
+    if (const StarNode *star = dynamic_cast<const StarNode *>(node))
+        return closure(NODE_STAR, canonical(star->getChild()));
+    if (const PlusNode *plus = dynamic_cast<const PlusNode *>(node))
+        return closure(NODE_PLUS, canonical(plus->getChild()));
+    if (const QuestionNode *question = dynamic_cast<const QuestionNode *>(node))
+        return closure(NODE_QUESTION, canonical(question->getChild()));
+    if (const RepeatNode *repeatNode = dynamic_cast<const RepeatNode *>(node))
+        return repeat(canonical(repeatNode->getChild()), repeatNode->getMin(), repeatNode->getMax());
+    throw std::runtime_error("cannot intern an unknown regex node");
+}
+
+RegexNode *RegexPool::find(const Key& key) const {
+    std::unordered_map<Key, RegexNode *, KeyHash>::const_iterator it = _nodes.find(key);
+
+    return it == _nodes.end() ? NULL : it->second;
+}
+
+RegexNode *RegexPool::add(const Key& key, RegexNode *node) {
+    _ids[node] = (int)_owned.size();
+    _owned.push_back(node);
+    _nodes[key] = node;
+    return node;
+}
+
+int RegexPool::id(const RegexNode *node) const {
+    return _ids.find(node)->second;
+}
+
+RegexNode *RegexPool::literal(char c) {
+    Key key = { NODE_LITERAL, -1, -1, std::string(1, c) };
+    RegexNode *node = find(key);
+
+    return node ? node : add(key, new LiteralNode(c));
+}
+
+/*
+Classes are keyed on the bytes they match, so [a-c] and [abc] are one
+node. The first class seen keeps its pattern.
+*/
+RegexNode *RegexPool::chars(const std::bitset<256>& set, const RegexNode *original) {
+    Key key = { NODE_CLASS, -1, -1, set.to_string() };
+    RegexNode *node = find(key);
+
+    if (node)
+        return node;
+    return add(key, original ? original->clone() : CharClassNode::fromChars(set));
+}
+
+RegexNode *RegexPool::dot() {
+    Key key = { NODE_DOT, -1, -1, "" };
+    RegexNode *node = find(key);
+
+    return node ? node : add(key, new DotNode());
+}
+
+RegexNode *RegexPool::concat(RegexNode *left, RegexNode *right) {
+    Key key = { NODE_CONCAT, id(left), id(right), "" };
+    RegexNode *node = find(key);
+
+    return node ? node : add(key, new ConcatNode(left, right));
+}
+
+/*
+Alternation is a union, so its operands can be regrouped: the single-byte
+ones merge into one class and repeats are dropped. What is left is
+rebuilt left-deep in its original order.
+*/
+RegexNode *RegexPool::alt(RegexNode *left, RegexNode *right) {
+    std::vector<RegexNode *> alternatives;
+    std::vector<RegexNode *> kept;
+    std::bitset<256> merged;
+    std::bitset<256> set;
+    RegexNode *single = NULL;
+    size_t singles = 0;
+    size_t classAt = 0;
+
+    flattenAlt(left, alternatives);
+    flattenAlt(right, alternatives);
+    for (RegexNode *alternative : alternatives) {
+        if (singleByte(alternative, set)) {
+            if (singles++ == 0) {
+                classAt = kept.size();
+                single = alternative;
+            }
+            merged |= set;
+        } else if (std::find(kept.begin(), kept.end(), alternative) == kept.end())
+            kept.push_back(alternative);
+    }
+    if (singles == 1)
+        kept.insert(kept.begin() + classAt, single);
+    else if (singles > 1)
+        kept.insert(kept.begin() + classAt, chars(merged, NULL));
+
+    RegexNode *result = kept[0];
+    for (size_t i = 1; i < kept.size(); i++) {
+        Key key = { NODE_ALT, id(result), id(kept[i]), "" };
+        RegexNode *node = find(key);
+        result = node ? node : add(key, new AltNode(result, kept[i]));
+    }
+    return result;
+}
+
+void RegexPool::flattenAlt(RegexNode *node, std::vector<RegexNode *>& alternatives) const {
+    if (AltNode *altNode = dynamic_cast<AltNode *>(node)) {
+        flattenAlt(altNode->getLeft(), alternatives);
+        flattenAlt(altNode->getRight(), alternatives);
+    } else
+        alternatives.push_back(node);
+}
+
+/*
+Nested closures collapse to one: a** and a+* and a?* are a*, a++ is a+,
+a?? is a?, and a+? and a?+ are a*.
+*/
+RegexNode *RegexPool::closure(Kind kind, RegexNode *child) {
+    if (dynamic_cast<StarNode *>(child) || dynamic_cast<PlusNode *>(child) || dynamic_cast<QuestionNode *>(child)) {
+        Kind inner = dynamic_cast<StarNode *>(child) ? NODE_STAR
+            : dynamic_cast<PlusNode *>(child) ? NODE_PLUS : NODE_QUESTION;
+
+        if (inner == NODE_STAR || inner == kind)
+            return child;
+        return closure(NODE_STAR, static_cast<UnaryNode *>(child)->getChild());
+    }
+
+    Key key = { kind, id(child), -1, "" };
+    RegexNode *node = find(key);
+    if (node)
+        return node;
+    if (kind == NODE_STAR)
+        return add(key, new StarNode(child));
+    if (kind == NODE_PLUS)
+        return add(key, new PlusNode(child));
+    return add(key, new QuestionNode(child));
+}
+
+RegexNode *RegexPool::repeat(RegexNode *child, int min, int max) {
+    Key key = { NODE_REPEAT, id(child), -1, std::to_string(min) + "," + std::to_string(max) };
+    RegexNode *node = find(key);
+
+    return node ? node : add(key, new RepeatNode(child, min, max));
+}
+
+bool RegexPool::singleByte(const RegexNode *node, std::bitset<256>& set) {
+    set.reset();
+    if (const LiteralNode *literalNode = dynamic_cast<const LiteralNode *>(node))
+        set.set((unsigned char)literalNode->getChar());
+    else if (const CharClassNode *classNode = dynamic_cast<const CharClassNode *>(node))
+        set = classNode->getChars();
+    else if (dynamic_cast<const DotNode *>(node)) {
+        set.set();
+        set.reset((unsigned char)'\n');
+    } else
+        return false;
+    return true;
+}
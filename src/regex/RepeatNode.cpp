@@ -0,0 +1,82 @@
+#include "../../inc/regex/RepeatNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
+#include <algorithm>
+
+RepeatNode::RepeatNode(RegexNode *c, int min, int max) : UnaryNode(c), min(min), max(max) {}
+
+int RepeatNode::getMin() const {
+    return min;
+}
+
+int RepeatNode::getMax() const {
+    return max;
+}
+
+RegexNode *RepeatNode::clone() const {
+    return new RepeatNode(child->clone(), min, max);
+}
+
+/*
+min copies in a chain, then either a looping copy or max - min copies
+that can each leave for the shared end state.
+*/
+NFAFragment RepeatNode::toNFA(NFA& nfa) const {
+    int start = nfa.addState();
+    int at = start;
+
+    for (int i = 0; i < min; i++) {
+        NFAFragment copy = this->child->toNFA(nfa);
+        nfa.addEpsilon(at, copy.start);
+        at = copy.end;
+    }
+
+    int end = nfa.addState();
+    if (max == UNBOUNDED) {
+        NFAFragment copy = this->child->toNFA(nfa);
+        nfa.addEpsilon(at, copy.start);
+        nfa.addEpsilon(at, end);
+        nfa.addEpsilon(copy.end, copy.start);
+        nfa.addEpsilon(copy.end, end);
+        return NFAFragment(start, end);
+    }
+    for (int i = min; i < max; i++) {
+        NFAFragment copy = this->child->toNFA(nfa);
+        nfa.addEpsilon(at, end);
+        nfa.addEpsilon(at, copy.start);
+        at = copy.end;
+    }
+    nfa.addEpsilon(at, end);
+    return NFAFragment(start, end);
+}
+
+/*
+Each copy follows only the one before it, so a copy's positions are merged
+once. Since every copy is the same expression, starting in the first copy
+and ending in any copy that may be the last loses no strings even when the
+child is nullable and copies could be skipped.
+*/
+PositionInfo RepeatNode::computePositions(PositionTable& table) const {
+    int copies = max == UNBOUNDED ? min + 1 : max;
+    PositionInfo info;
+    PositionInfo previous;
+
+    info.nullable = true;
+    for (int i = 0; i < copies; i++) {
+        PositionInfo copy = this->child->computePositions(table);
+
+        if (i == 0) {
+            info.firstpos = copy.firstpos;
+            info.nullable = min == 0 || copy.nullable;
+        } else
+            table.addFollow(previous.lastpos, copy.firstpos);
+        if (max == UNBOUNDED && i == copies - 1)
+            table.addFollow(copy.lastpos, copy.firstpos);
+        if (i + 1 >= min || copy.nullable)
+            info.lastpos.insert(info.lastpos.end(), copy.lastpos.begin(), copy.lastpos.end());
+        previous = copy;
+    }
+    std::sort(info.lastpos.begin(), info.lastpos.end());
+    info.lastpos.erase(std::unique(info.lastpos.begin(), info.lastpos.end()), info.lastpos.end());
+    return info;
+}
@@ -1,17 +1,31 @@
 #include "../../inc/regex/StarNode.hpp"
+#include "../../inc/nfa/NFA.hpp"
+#include "../../inc/regex/Positions.hpp"
 
 StarNode::StarNode(RegexNode *c) : UnaryNode(c) {}
 
-NFAFragment StarNode::toNFA(int& stateCounter) {
-    NFAFragment child = this->child->toNFA(stateCounter);
+RegexNode *StarNode::clone() const {
+    return new StarNode(child->clone());
+}
 
-    NFAState *start = new NFAState(stateCounter++);
-    NFAState *end = new NFAState(stateCounter++);
+NFAFragment StarNode::toNFA(NFA& nfa) const {
+    NFAFragment child = this->child->toNFA(nfa);
 
-    start->epsilonTransitions.insert(end);
-    start->epsilonTransitions.insert(child.start);
-    child.end->epsilonTransitions.insert(end);
-    child.end->epsilonTransitions.insert(child.start);
+    int start = nfa.addState();
+    int end = nfa.addState();
+
+    nfa.addEpsilon(start, end);
+    nfa.addEpsilon(start, child.start);
+    nfa.addEpsilon(child.end, end);
+    nfa.addEpsilon(child.end, child.start);
 
     return NFAFragment(start, end);
-}
\ No newline at end of file
+}
+
+PositionInfo StarNode::computePositions(PositionTable& table) const {
+    PositionInfo info = this->child->computePositions(table);
+
+    table.addFollow(info.lastpos, info.firstpos);
+    info.nullable = true;
+    return info;
+}
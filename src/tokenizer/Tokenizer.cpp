@@ -1,10 +1,17 @@
 #include "../../inc/tokenizer/Tokenizer.hpp"
+#include "../../inc/utils/StringUtils.hpp"
 
-Token::Token(TokenType t, const std::string& v, int line, int col)
+Token::Token(TokenType t, std::string_view v, int line, int col)
     :   type(t), value(v), line(line), column(col) {}
 
-Tokenizer::Tokenizer(const std::string& input) 
-    : _input(input), _pos(0), _line(1), _column(1), tokens() {}
+Tokenizer::Tokenizer(std::string_view input)
+    : _input(input), _pos(0), _line(1), _column(1), _section(SECTION_HEADER), _inPattern(false), _pending() {}
+
+Tokenizer Tokenizer::forPattern(std::string_view pattern) {
+    Tokenizer tokenizer(pattern);
+    tokenizer._section = SECTION_PATTERN;
+    return tokenizer;
+}
 
 char Tokenizer::peek() const {
     if (isAtEnd()) return '\0';
@@ -32,34 +39,22 @@ bool Tokenizer::isAtEnd() const {
     return _pos >= _input.size();
 }
 
+/*
+The text between the quotes, escapes included; the parser decodes it.
+*/
 Token Tokenizer::lexString() {
     int startLine = _line;
     int startCol = _column;
-    std::string val;
 
     advance();
+    size_t start = _pos;
     while (!isAtEnd() && peek() != '"') {
-        if (peek() == '\\') {
+        if (advance() == '\\' && !isAtEnd())
             advance();
-            char escaped = advance();
-            switch(escaped) {
-                case 'n': val += '\n'; break;
-                case 't': val += '\t'; break;
-                case 'r': val += '\r'; break;
-                case '\\': val += '\\'; break;
-                case '"': val += '"'; break;
-                case '0': val += '\0'; break;
-                default: 
-                    val += '\\';
-                    val += escaped;
-                    break;
-            }
-        } else {
-            val += advance();
-        }
-    } 
+    }
     if (isAtEnd())
         throw std::runtime_error("unterminated string at line " + std::to_string(startLine));
+    std::string_view val = _input.substr(start, _pos - start);
     advance();
     return Token(TOK_STRING, val, startLine, startCol);
 }
@@ -67,31 +62,28 @@ Token Tokenizer::lexString() {
 Token Tokenizer::lexCharClass() {
     int startLine = _line;
     int startCol = _column;
-    std::string val;
 
     advance();
+    size_t start = _pos;
 
     if (peek() == '^')
-        val += advance();
+        advance();
 
     while(!isAtEnd()) {
         if (peek() == ']') {
-            if (val.length() > 0 && val.back() == ':') {
-                val += advance();
+            if (_pos > start && _input[_pos - 1] == ':') {
+                advance();
                 continue;
             }
             break;
         }
-        if (peek() == '\\') {
-            val += advance();
-            val += advance();
-        } else {
-            val += advance();
-        }
+        if (advance() == '\\' && !isAtEnd())
+            advance();
     }
     if (isAtEnd())
         throw std::runtime_error("unterminated character class at line " + std::to_string(startLine));
-    
+
+    std::string_view val = _input.substr(start, _pos - start);
     advance();
     return Token(TOK_CHARCLASS, val, startLine, startCol);
 }
@@ -99,16 +91,15 @@ Token Tokenizer::lexCharClass() {
 Token Tokenizer::lexCCode() {
     int startLine = _line;
     int startCol = _column;
-    std::string val;
+    size_t start = _pos;
 
     int braceDepth = 0;
 
     if (peek() == '{') {
-        val += advance();
+        advance();
         braceDepth = 1;
         while (!isAtEnd() && braceDepth > 0) {
             char c = advance();
-            val += c;
             if (c == '{')
                 braceDepth++;
             else if (c == '}')
@@ -116,9 +107,9 @@ Token Tokenizer::lexCCode() {
         }
     } else {
         while (!isAtEnd() && peek() != '\n')
-            val += advance();
+            advance();
     }
-    return Token(TOK_C_CODE, val, startLine, startCol);
+    return Token(TOK_C_CODE, _input.substr(start, _pos - start), startLine, startCol);
 }
 
 Token Tokenizer::lexPercentDirective() {
@@ -144,12 +135,14 @@ Token Tokenizer::lexPercentDirective() {
 Token Tokenizer::lexBrace() {
     int startLine = _line;
     int startCol = _column;
-    std::string value;
 
     advance();
-    while (!isAtEnd() && peek() != '}') {
-        value += advance();
-    }
+    size_t start = _pos;
+    while (!isAtEnd() && peek() != '}')
+        advance();
+    if (isAtEnd())
+        throw std::runtime_error("unterminated { at line " + std::to_string(startLine));
+    std::string_view value = _input.substr(start, _pos - start);
     advance();
 
     if (value.empty())
@@ -167,18 +160,17 @@ Token Tokenizer::lexBrace() {
     return Token(TOK_DEFINITION_REFERENCE, value, startLine, startCol);
 }
 
+/*
+The whole definition line, name first; the parser splits off the pattern.
+*/
 Token Tokenizer::lexDefiniton() {
     int startLine = _line;
     int startCol = _column;
-    std::string value;
+    size_t start = _pos;
 
-    while(!isAtEnd() && !std::isspace(peek()))
-        value += advance();
-    skipWhitespace();
-    value += ' ';
     while (!isAtEnd() && peek() != '\n')
-        value += advance();
-    return Token(TOK_DEFINITION, value, startLine, startCol);  
+        advance();
+    return Token(TOK_DEFINITION, _input.substr(start, _pos - start), startLine, startCol);
 }
 
 void Tokenizer::skipNewlines() {
@@ -218,134 +210,187 @@ void Tokenizer::tokenizeAction() {
     skipWhitespace();
 
     if (isAtEnd() || peek() == '\n') {
-        tokens.push_back(Token(TOK_C_CODE, "", _line, _column));
+        _pending.push_back(Token(TOK_C_CODE, "", _line, _column));
         if (peek() == '\n')
             advance();
-        tokens.push_back(Token(TOK_NEWLINE, "\n", _line, _column));
+        _pending.push_back(Token(TOK_NEWLINE, "\n", _line, _column));
         return;
     }
 
     if (peek() == '|') {
         advance();
-        tokens.push_back(Token(TOK_PIPE, "|", _line, _column));
+        _pending.push_back(Token(TOK_PIPE, "|", _line, _column));
         if (peek() == '\n') {
             advance();
-            tokens.push_back(Token(TOK_NEWLINE, "\n", _line, _column));
+            _pending.push_back(Token(TOK_NEWLINE, "\n", _line, _column));
         }
         return;
     }
-    tokens.push_back(lexCCode());
+    _pending.push_back(lexCCode());
     if (peek() == '\n') {
         advance();
-        tokens.push_back(Token(TOK_NEWLINE, "\n", _line, _column));
+        _pending.push_back(Token(TOK_NEWLINE, "\n", _line, _column));
     }
 }
 
-void Tokenizer::tokenizePattern() {
-    while (!isAtEnd() && peek() != '\n') {
-        if (std::isspace(peek()) && peek() != '\n')
-            return ;
-        char c = peek();
-        switch(c) {
-            case '"': tokens.push_back(lexString()); break;
-            case '[': tokens.push_back(lexCharClass()); break;
-            case '{': tokens.push_back(lexBrace()); break;
-            case '|': advance(); tokens.push_back(Token(TOK_PIPE,     "|", _line, _column)); break;
-            case '*': advance(); tokens.push_back(Token(TOK_STAR,     "*", _line, _column)); break;
-            case '+': advance(); tokens.push_back(Token(TOK_PLUS,     "+", _line, _column)); break;
-            case '?': advance(); tokens.push_back(Token(TOK_QUESTION, "?", _line, _column)); break;
-            case '(': advance(); tokens.push_back(Token(TOK_LPAREN,   "(", _line, _column)); break;
-            case ')': advance(); tokens.push_back(Token(TOK_RPAREN,   ")", _line, _column)); break;
-            case '.': advance(); tokens.push_back(Token(TOK_DOT,      ".", _line, _column)); break;
-            case '^': advance(); tokens.push_back(Token(TOK_CARET,    "^", _line, _column)); break;
-            case '$': advance(); tokens.push_back(Token(TOK_DOLLAR,   "$", _line, _column)); break;
-            case '\\':
+/*
+One token of a pattern. A backslash escape becomes a TOK_LITERAL holding
+the raw sequence, backslash included.
+*/
+Token Tokenizer::lexPatternToken() {
+    int line = _line;
+    int column = _column;
+    size_t start = _pos;
+    char c = peek();
+
+    switch(c) {
+        case '"': return lexString();
+        case '[': return lexCharClass();
+        case '{': return lexBrace();
+        case '|': advance(); return Token(TOK_PIPE,     "|", line, column);
+        case '*': advance(); return Token(TOK_STAR,     "*", line, column);
+        case '+': advance(); return Token(TOK_PLUS,     "+", line, column);
+        case '?': advance(); return Token(TOK_QUESTION, "?", line, column);
+        case '(': advance(); return Token(TOK_LPAREN,   "(", line, column);
+        case ')': advance(); return Token(TOK_RPAREN,   ")", line, column);
+        case '.': advance(); return Token(TOK_DOT,      ".", line, column);
+        case '^': advance(); return Token(TOK_CARET,    "^", line, column);
+        case '$': advance(); return Token(TOK_DOLLAR,   "$", line, column);
+        case '\\': {
+            size_t end = _pos + 1;
+            unescapeChar(_input, end);
+            while (_pos < end)
                 advance();
-                tokens.push_back(Token(TOK_LITERAL, std::string(1, advance()), _line, _column));
-                break;
-            default:
-                advance();
-                tokens.push_back(Token(TOK_LITERAL, std::string(1, c), _line, _column));
-                break;
-
+            return Token(TOK_LITERAL, _input.substr(start, end - start), line, column);
         }
-    } 
+        default:
+            advance();
+            return Token(TOK_LITERAL, _input.substr(start, 1), line, column);
+    }
+}
+
+/*
+Patterns end at the first blank or newline.
+*/
+void Tokenizer::tokenizePattern() {
+    if (isAtEnd() || std::isspace(peek())) {
+        _pending.push_back(Token(TOK_EOF, "", _line, _column));
+        _section = SECTION_END;
+        return ;
+    }
+    _pending.push_back(lexPatternToken());
 }
 
+/*
+One step of the rules section: the %% that ends it, the next pattern
+token, or the action that follows a pattern.
+*/
 void Tokenizer::tokenizeRules() {
-    while (!isAtEnd()) {
+    if (!_inPattern) {
         skipNewlines();
+        if (isAtEnd()) {
+            _section = SECTION_CODE;
+            return ;
+        }
         if (peek() == '%' && peekNext() == '%') {
             advance();
             advance();
-            tokens.push_back(Token(TOK_PERCENT_PERCENT, "%%", _line, _column));
+            _pending.push_back(Token(TOK_PERCENT_PERCENT, "%%", _line, _column));
+            _section = SECTION_CODE;
             return ;
         }
-        tokenizePattern();
+        _inPattern = true;
+    }
+    if (isAtEnd() || std::isspace(peek())) {
+        _inPattern = false;
         tokenizeAction();
+        return ;
     }
+    _pending.push_back(lexPatternToken());
 }
 
+/*
+One step of the definitions section: a comment, a %{ %} block, a
+definition, or the %% that ends the section.
+*/
 void Tokenizer::tokenizeHeader() {
-    while (!isAtEnd()) {
-        skipNewlines();
+    skipNewlines();
+    if (isAtEnd())
+        throw std::runtime_error("unexcpected EOF: missing %%");
 
-        if (peek() == '/' && peekNext() == '*') {
-            skipComment();
-            continue;
-        }
-        if (peek() == '%' && peekNext() == '%') {
-            advance();
-            advance();
-            tokens.push_back(Token(TOK_PERCENT_PERCENT, "%%", _line, _column));
-            return ;
-        }
-        if (peek() == '%' && peekNext() == '{') {
-            advance();
-            advance();
-            tokens.push_back(Token(TOK_PERCENT_LBRACE, "%{", _line, _column));
-            
-            std::string code;
-            while (!isAtEnd()) {
-                if (peek() == '%' && peekNext() == '}') {
-                    advance();
-                    advance();
-                    break;
-                }
-                code += advance();
+    if (peek() == '/' && peekNext() == '*') {
+        skipComment();
+        return ;
+    }
+    if (peek() == '%' && peekNext() == '%') {
+        advance();
+        advance();
+        _pending.push_back(Token(TOK_PERCENT_PERCENT, "%%", _line, _column));
+        _section = SECTION_RULES;
+        return ;
+    }
+    if (peek() == '%' && peekNext() == '{') {
+        advance();
+        advance();
+        _pending.push_back(Token(TOK_PERCENT_LBRACE, "%{", _line, _column));
+
+        size_t start = _pos;
+        size_t end = _input.size();
+        while (!isAtEnd()) {
+            if (peek() == '%' && peekNext() == '}') {
+                end = _pos;
+                advance();
+                advance();
+                break;
             }
-            tokens.push_back(Token(TOK_C_CODE, code, _line, _column));
-            tokens.push_back(Token(TOK_PERCENT_RBRACE, "%}", _line, _column));
-            continue; 
-        }
-        tokens.push_back(lexDefiniton());
-        if (peek() == '\n')
             advance();
+        }
+        _pending.push_back(Token(TOK_C_CODE, _input.substr(start, end - start), _line, _column));
+        _pending.push_back(Token(TOK_PERCENT_RBRACE, "%}", _line, _column));
+        return ;
     }
-    throw std::runtime_error("unexcpected EOF: missing %%");
+    _pending.push_back(lexDefiniton());
+    if (peek() == '\n')
+        advance();
 }
 
 void Tokenizer::tokenizeCode() {
     int startline = _line;
     int startColumn = _column;
-    std::string value;
+    std::string_view value = _input.substr(_pos);
 
     while (!isAtEnd())
-        value += advance();
+        advance();
     if (!value.empty())
-        tokens.push_back(Token(TOK_C_CODE, value, startline, startColumn));
+        _pending.push_back(Token(TOK_C_CODE, value, startline, startColumn));
+    _pending.push_back(Token(TOK_EOF, "", _line, _column));
+    _section = SECTION_END;
 }
 
-std::vector<Token> Tokenizer::tokenize() {
-    tokenizeHeader();
-    tokenizeRules();
-    tokenizeCode();
-    tokens.push_back(Token(TOK_EOF, "", _line, _column));
-    return tokens;
+Token Tokenizer::next() {
+    while (_pending.empty()) {
+        switch (_section) {
+            case SECTION_HEADER: tokenizeHeader(); break;
+            case SECTION_RULES: tokenizeRules(); break;
+            case SECTION_CODE: tokenizeCode(); break;
+            case SECTION_PATTERN: tokenizePattern(); break;
+            case SECTION_END: _pending.push_back(Token(TOK_EOF, "", _line, _column)); break;
+        }
+    }
+    Token token = _pending.front();
+    _pending.pop_front();
+    return token;
 }
 
-std::vector<Token> Tokenizer::tokenizePatternExtern() {
-    tokenizePattern();
+/*
+All the tokens at once, for --debug.
+*/
+std::vector<Token> Tokenizer::tokenize() {
+    std::vector<Token> tokens;
+
+    do
+        tokens.push_back(next());
+    while (tokens.back().type != TOK_EOF);
     return tokens;
 }
 
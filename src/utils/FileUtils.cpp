@@ -1,35 +1,130 @@
 #include "../inc/utils/FileUtils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 
-bool	fileExists(const std::string& path)
+/*
+Appends everything left on fd to content. hint is the expected size (from
+fstat); with one spare byte past it a regular file is one read() plus the
+read() that sees end of file.
+*/
+bool	readAll(int fd, std::string& content, size_t hint)
 {
-	struct stat buff;
+	size_t	used = content.size();
 
-	if (stat(path.c_str(), &buff) != 0)
-		return (false);
+	content.resize(used + hint + 1);
+	while (true)
+	{
+		if (used == content.size())
+			content.resize(used + std::max<size_t>(65536, used));
+		ssize_t n = read(fd, &content[used], content.size() - used);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n < 0)
+		{
+			content.resize(used);
+			return (false);
+		}
+		if (n == 0)
+			break ;
+		used += n;
+	}
+	content.resize(used);
 	return (true);
 }
 
-bool	isReadable(const std::string& path)
+/*
+The whole file, read with one open() and fstat(); throws with the failing
+call's error.
+*/
+std::string readFile(const std::string& path)
 {
-	if (access(path.c_str(), R_OK) != 0)
-		return (false);
-	return (true);
+	std::string	content;
+	struct stat	st;
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+	if (fstat(fd, &st) != 0)
+	{
+		int saved = errno;
+		close(fd);
+		throw std::runtime_error("cannot stat " + path + ": " + std::strerror(saved));
+	}
+	bool ok = readAll(fd, content, S_ISREG(st.st_mode) ? st.st_size : 0);
+	int saved = errno;
+	close(fd);
+	if (!ok)
+		throw std::runtime_error("cannot read " + path + ": " + std::strerror(saved));
+	return (content);
 }
 
-std::string readFile(const std::string& path)
+MappedFile::MappedFile() : _map(NULL), _mapSize(0), _buffer() {}
+
+MappedFile::MappedFile(const std::string& path) : _map(NULL), _mapSize(0), _buffer()
+{
+	struct stat	st;
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+	{
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED)
+		{
+			madvise(map, st.st_size, MADV_SEQUENTIAL);
+			_map = map;
+			_mapSize = st.st_size;
+			close(fd);
+			return ;
+		}
+	}
+	// pipes, empty files and anything mmap refuses
+	bool ok = readAll(fd, _buffer, 0);
+	int saved = errno;
+	close(fd);
+	if (!ok)
+		throw std::runtime_error("cannot read " + path + ": " + std::strerror(saved));
+}
+
+MappedFile::~MappedFile()
 {
-	std::string content;
-	char c;
+	release();
+}
 
-	if (!fileExists(path) || !isReadable(path))
-		return "";
+MappedFile::MappedFile(MappedFile&& other)
+	:	_map(other._map), _mapSize(other._mapSize), _buffer(std::move(other._buffer))
+{
+	other._map = NULL;
+	other._mapSize = 0;
+}
 
-	std::ifstream f(path.c_str(), std::ios::binary);
-	if (!f.is_open())
-		return "";
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+	if (this != &other)
+	{
+		release();
+		_map = other._map;
+		_mapSize = other._mapSize;
+		_buffer = std::move(other._buffer);
+		other._map = NULL;
+		other._mapSize = 0;
+	}
+	return (*this);
+}
 
-	while (f.get(c))
-		content += c;
+void	MappedFile::release()
+{
+	if (_map)
+		munmap(_map, _mapSize);
+	_map = NULL;
+	_mapSize = 0;
+}
 
-	return (content);
-}
\ No newline at end of file
+std::string_view	MappedFile::view() const
+{
+	if (_map)
+		return std::string_view(static_cast<const char *>(_map), _mapSize);
+	return std::string_view(_buffer);
+}
@@ -16,6 +16,6 @@ void	logError(const std::string &message)
 
 void	logInfo(const std::string &message)
 {
-	std::cout << "[" << getCurrentTimestamp() << "] [INFO] "
+	std::cerr << "[" << getCurrentTimestamp() << "] [INFO] "
 			  << message << std::endl;
 }
@@ -0,0 +1,91 @@
+#include "../inc/utils/Options.hpp"
+
+Options::Options()
+	: input(), followpos(false), threads(1), scan(), lazy(false), lazyCache(1 << 20), tables("full"),
+	  stdoutOutput(false), debug(false), direct(false), mmap(false),
+	  backupReport(false), noBackup(false), simd(true),
+	  keywords(true), parallel(false), batch(false) {}
+
+static std::string	nextArgument(int argc, char **argv, int& i)
+{
+	if (i + 1 >= argc)
+		throw std::runtime_error(std::string(argv[i]) + " needs an argument\n" + usage());
+	return (std::string(argv[++i]));
+}
+
+std::string	usage()
+{
+	return ("Usage: ./ft_lex [-t] [-b] [--no-backup] [--debug] [--followpos] [-j threads] "
+		"[--tables=full|comb|compact | --direct] [--mmap] [--parallel] [--batch] [--no-simd] [--no-keywords] [--scan input [--lazy] [--lazy-cache KB]] <file.l>");
+}
+
+Options	parseOptions(int argc, char **argv)
+{
+	Options	options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+
+		if (arg == "-t")
+			options.stdoutOutput = true;
+		else if (arg == "--debug")
+			options.debug = true;
+		else if (arg == "--direct")
+			options.direct = true;
+		else if (arg == "-b")
+			options.backupReport = true;
+		else if (arg == "--no-backup")
+			options.noBackup = true;
+		else if (arg == "--no-simd")
+			options.simd = false;
+		else if (arg == "--no-keywords")
+			options.keywords = false;
+		else if (arg == "--mmap")
+			options.mmap = true;
+		else if (arg == "--parallel")
+			options.parallel = true;
+		else if (arg == "--batch")
+			options.batch = true;
+		else if (arg == "--followpos")
+			options.followpos = true;
+		else if (arg == "-j")
+		{
+			options.threads = std::atoi(nextArgument(argc, argv, i).c_str());
+			if (options.threads < 1)
+				throw std::runtime_error("invalid thread count: " + std::string(argv[i]));
+		}
+		else if (arg == "--scan")
+			options.scan = nextArgument(argc, argv, i);
+		else if (arg == "--lazy")
+			options.lazy = true;
+		else if (arg == "--lazy-cache")
+		{
+			int kb = std::atoi(nextArgument(argc, argv, i).c_str());
+			if (kb < 1)
+				throw std::runtime_error("invalid cache size: " + std::string(argv[i]));
+			options.lazy = true;
+			options.lazyCache = (size_t)kb << 10;
+		}
+		else if (arg.compare(0, 9, "--tables=") == 0)
+		{
+			options.tables = arg.substr(9);
+			if (options.tables != "full" && options.tables != "comb" && options.tables != "compact")
+				throw std::runtime_error("unknown table layout: " + options.tables + "\n" + usage());
+		}
+		else if (arg.size() > 1 && arg[0] == '-')
+			throw std::runtime_error("unknown option: " + arg + "\n" + usage());
+		else if (options.input.empty())
+			options.input = arg;
+		else
+			throw std::runtime_error("unexpected argument: " + arg + "\n" + usage());
+	}
+	if (options.input.empty())
+		throw std::runtime_error(usage());
+	if (options.lazy && options.scan.empty())
+		throw std::runtime_error("--lazy only applies to --scan\n" + usage());
+	if ((options.parallel || options.batch) && options.direct)
+		throw std::runtime_error(std::string(options.parallel ? "--parallel" : "--batch")
+			+ " needs a table scanner, not --direct\n" + usage());
+	return (options);
+}
@@ -49,3 +49,77 @@ std::vector<std::string> split(const std::string &str, char delim)
 	}
 	return (container);
 }
+
+std::string escape(const std::string &str)
+{
+	std::string result;
+	const char *hex = "0123456789abcdef";
+
+	for (size_t i = 0; i < str.size(); i++)
+	{
+		unsigned char c = str[i];
+		if (c == '\n')
+			result += "\\n";
+		else if (c == '\t')
+			result += "\\t";
+		else if (c == '\r')
+			result += "\\r";
+		else if (c == '\\' || c == '"')
+		{
+			result += '\\';
+			result += c;
+		}
+		else if (c < 32 || c >= 127)
+		{
+			result += "\\x";
+			result += hex[c >> 4];
+			result += hex[c & 15];
+		}
+		else
+			result += c;
+	}
+	return (result);
+}
+
+/*
+Decodes the escape sequence that starts at str[i], just past its
+backslash, and leaves i after it: the C letter escapes, up to three octal
+digits, \x with up to two hex digits, or the character itself.
+*/
+char	unescapeChar(std::string_view str, size_t &i)
+{
+	char	c;
+	int		value = 0;
+	int		digits = 0;
+
+	if (i >= str.size())
+		return ('\\');
+	c = str[i++];
+	switch (c)
+	{
+		case 'n': return ('\n');
+		case 't': return ('\t');
+		case 'r': return ('\r');
+		case 'f': return ('\f');
+		case 'v': return ('\v');
+		case 'a': return ('\a');
+		case 'b': return ('\b');
+		case 'x':
+			while (digits < 2 && i < str.size() && std::isxdigit((unsigned char)str[i]))
+			{
+				value = value * 16 + (std::isdigit((unsigned char)str[i])
+					? str[i] - '0' : std::tolower((unsigned char)str[i]) - 'a' + 10);
+				i++;
+				digits++;
+			}
+			return (digits ? (char)value : 'x');
+		default:
+			break ;
+	}
+	if (c < '0' || c > '7')
+		return (c);
+	value = c - '0';
+	while (++digits < 3 && i < str.size() && str[i] >= '0' && str[i] <= '7')
+		value = value * 8 + (str[i++] - '0');
+	return ((char)value);
+}